@@ -19,24 +19,14 @@
 // System includes
 #include <stdbool.h>
 #include <stdint.h>
-#include <stdlib.h>
-#include <stdio.h>
 #include <string.h>
-#include <inttypes.h>
-
-// TI platform includes
-#include "inc/hw_memmap.h"
-#include "inc/hw_ints.h"
-#include "driverlib/sysctl.h"
-#include "driverlib/interrupt.h"
-#include "driverlib/pin_map.h"
-#include "driverlib/gpio.h"
-#include "driverlib/uart.h"
-
-// Our includes
+
+// Our includes. The decoder makes no driverlib calls, the radio hardware is behind radio.h.
 #include "config.h"
 #include "logging.h"
 #include "hardware.h"
+#include "radio.h"
+#include "ringbuf.h"
 
 // This file's include
 #include "MSF60decode.h"
@@ -47,13 +37,141 @@
  *      PRIVATE MACROS AND DEFINES
  ************************************************************************************************************/
 
-// Allow +/- 30ms on signal timings
-#define     PULSE_MARGIN            30
+// The shortest nominal time between any two carrier edges, and the length of a second/cell, in milliseconds
+#define     MIN_EDGE_INTERVAL       100
+#define     CELL_LENGTH             1000
 
 // My cheapo AliExpress MSF60 receiver board inverts the sense of the carrier signal
 #define     CARRIER_ON              0
 #define     CARRIER_OFF             1
 
+// Pseudo carrier level passed to HandleCarrierEvent() when radio edges have been lost
+#define     CARRIER_EDGES_LOST      2
+
+// The A and B bits are packed MSB first, second n of the frame is bit (63 - n) of the word.
+// That way each BCD field is in its natural bit order and can be extracted with one shift & mask.
+#define     FRAME_BIT(n)                    (1ULL << (63 - (n)))
+#define     FRAME_MASK(from, to)            ((~0ULL >> (from)) & ~(~0ULL >> ((to) + 1)))
+#define     FRAME_FIELD(word, from, to)     ((uint32_t)((word) >> (63 - (to))) & ((1UL << ((to) - (from) + 1)) - 1))
+
+// Bits A52 through A59 are always 01111110
+#define     FRAME_MARKER                    0x7E
+
+// Erasure mask of a frame with none of its cells received
+#define     FRAME_ALL_ERASED                FRAME_MASK(1, 59)
+
+#if !RING_SIZE_OK(MSF_EDGE_QUEUE_SIZE)
+#error "MSF_EDGE_QUEUE_SIZE must be a power of 2"
+#endif
+
+#if (MSF_EVENT_QUEUE_SIZE > 0) && !RING_SIZE_OK(MSF_EVENT_QUEUE_SIZE)
+#error "MSF_EVENT_QUEUE_SIZE must be a power of 2"
+#endif
+
+// MSF_Process() passes each edge to the selected decoder engine
+#if (MSF_DECODER_ENGINE == MSF_ENGINE_SOFT)
+#define     DecodeCarrierEvent      SoftCarrierEvent
+#else
+#define     DecodeCarrierEvent      HandleCarrierEvent
+#endif
+
+// Soft decoder tuning. Costs & confidences are in milliseconds of carrier time.
+#define     SOFT_NUM_SLOTS          5               // Slots per cell the OFF time is measured over
+#define     SOFT_NUM_PATTERNS       5               // The four A/B bit pairs plus the minute marker
+#define     SOFT_MAX_CELL_EDGES     16              // Edges recorded per cell, any more are ignored
+#define     SOFT_OFF_HISTORY        4               // CARRIER_OFF edges remembered to find the 1 Hz phase
+#define     SOFT_BAD_CELL_COST      150             // A cell this far from every pattern is noise or the wrong phase
+#define     SOFT_MAX_BAD_CELLS      5               // Consecutive bad cells before SYNC is lost
+#define     SOFT_MAX_FLYWHEEL       3               // Consecutive missing second markers before SYNC is lost
+#define     SOFT_RECOVER_CONFIDENCE 50              // Only bits less certain than this are corrected by parity
+#define     SOFT_MAX_CONFIDENCE     100
+
+// Hard decoder tuning
+#define     HARD_MAX_LOST_CELLS     3               // Consecutive cells lost before the 1 Hz phase is lost
+
+// Free running clock. Second markers further than this from where the clock expects them are ignored.
+#define     CLOCK_MAX_CORRECTION    100             // ms
+#define     CLOCK_HOLDOVER_SECONDS  2               // Seconds without a second marker before the clock is in holdover
+
+// The clock counts UK civil seconds from 2000. Unix time is UTC seconds from 1970.
+#define     UNIX_TIME_2000          946684800UL     // 00:00:00 1st Jan 2000 UTC
+#define     BST_OFFSET              3600            // Seconds BST is ahead of UTC
+#define     BST_CHANGE_HOUR         1               // The UK changes at 01:00 UTC
+
+// Oscillator drift is measured by a least squares fit of the second marker phase over each block of seconds
+#define     DRIFT_BLOCK_SECONDS     900
+#define     DRIFT_MIN_MARKERS       (DRIFT_BLOCK_SECONDS / 2)   // Second markers needed in a block for a valid fit
+#define     DRIFT_FILTER_SHIFT      2               // Each new fit moves the estimate 1/4 of the way
+
+// Pulse width calibration, see MSF_ADAPTIVE_MARGINS
+#define     ADAPT_MIN_FRAMES        3               // Good frames learned from before the bands are narrowed
+#define     ADAPT_SPREADS           4               // Band half width in mean absolute deviations, about 3 sigma
+#define     ADAPT_MIN_MARGIN        24              // ms, the narrowest band, it must still pass an edge moved by a glitch
+#define     ADAPT_FILTER_SHIFT      2               // Each good frame moves the calibration 1/4 of the way
+#define     ADAPT_FIRST_INTERVALS   30              // CARRIER_ON widths in margin to learn the bias before the first good frame
+
+// The intervals the hard engine classifies. From an OFF edge to an ON edge includes the receiver's
+// extra delay on ON edges, from an ON edge to an OFF edge is short by it and OFF to OFF has none.
+#define     INTERVAL_OFF_TO_ON      0
+#define     INTERVAL_ON_TO_OFF      1
+#define     INTERVAL_OFF_TO_OFF     2
+
+// Polarity detection, see MSF_DETECT_POLARITY. Pulses this long are only sent with the carrier ON.
+#define     POLARITY_LONG_MIN       650             // ms
+#define     POLARITY_LONG_MAX       950             // ms
+#define     POLARITY_VOTES          8               // Net long CARRIER_OFF pulses before inverting
+
+// Signal quality averages move 1/16 of the way to each new sample, all scaled by 256
+#define     QUALITY_FILTER_SHIFT    4
+#define     QUALITY_BIN_MS          5               // Width of each edge error histogram bin
+#define     QUALITY_PARITY_BITS     39              // Bits covered by the four parity checks, B54-B57 included
+
+// Edge timestamps are in 'ticks'. Convert an interval to the nearest millisecond for classification.
+#if (HW_ENABLE_CAPTURE_TIMER == 1)
+#define     TICKS_TO_MS(t)          (((t) + (ui32TicksPerMs / 2)) / ui32TicksPerMs)
+#define     MS_TO_TICKS(ms)         ((ms) * ui32TicksPerMs)
+#else
+#define     TICKS_TO_MS(t)          (t)
+#define     MS_TO_TICKS(ms)         (ms)
+#endif
+
+// Optional decoder statistics, timed with the radio interface's cycle counter
+#if (MSF_ENABLE_STATS == 1)
+#define     CYCLE_COUNT()           Radio_GetCycleCount()
+#define     STAT_COUNT(ev)          (pRx->Stats.Events[ (ev) ]++)
+#define     STAT_INC(field)         (pRx->Stats.field++)
+#define     STAT_FAIL(voted, field) ((voted) ? pRx->Stats.VotedFailures++ : pRx->Stats.field++)
+#define     STAT_TIME(section, statement)                                                           \
+                                    do {                                                            \
+                                        uint32_t stat_start = CYCLE_COUNT();                        \
+                                        statement;                                                  \
+                                        StatAddCycles( &pRx->Stats.section, stat_start );           \
+                                    } while (0)
+#else
+#define     STAT_COUNT(ev)
+#define     STAT_INC(field)
+#define     STAT_FAIL(voted, field) ((void)(voted))
+#define     STAT_TIME(section, statement)   do { statement; } while (0)
+#endif
+
+
+
+
+/**
+ * With MSF_PACKED_STATE the receiver state flags take a bit each and its small counters and
+ * enums a byte. The struct isn't packed as such, a Cortex-M0 can't make unaligned accesses,
+ * so the small members are kept next to each other where they can share a word.
+ */
+#if (MSF_PACKED_STATE == 1)
+#define     FLAG( name )            bool name : 1
+#define     SMALL_COUNT             uint8_t
+#define     SMALL_ENUM( type )      uint8_t
+#else
+#define     FLAG( name )            bool name
+#define     SMALL_COUNT             unsigned
+#define     SMALL_ENUM( type )      type
+#endif
+
 
 
 /************************************************************************************************************
@@ -74,13 +192,67 @@ typedef enum {
 } eWidth;
 
 
+// A carrier edge as timestamped by the radio ISR
+typedef struct {
+    uint32_t    time;                   // Tick count when the edge occurred
+    uint32_t    level;                  // CARRIER_ON or CARRIER_OFF
+} sEdgeEvent;
+
+
+// A client event waiting for MSF_DispatchEvents()
+typedef struct {
+    uint32_t    time;                   // Tick count when it was queued
+    uint16_t    type;                   // eMSFEventType
+    uint16_t    receiver;               // Receiver it came from
+} sClientEvent;
+
+
 
 /************************************************************************************************************
- *      EXTERN VARIABLES
+ *      PULSE WIDTH LOOKUP TABLES
  ************************************************************************************************************/
 
-// We need access to a millisecond resolution uin32_t tick counter for timing.
-extern volatile uint32_t g_msSysTick;
+/**
+ * Pulse widths are classified with a single table lookup. Each table entry covers a
+ * (1 << WIDTH_TABLE_SHIFT) millisecond bucket and is classified by the centre of the
+ * bucket at compile time, so band edges are rounded to the table resolution.
+ * Widths beyond the end of the table are always eWidth_INVALID.
+ */
+#define     WIDTH_TABLE_SHIFT       2
+#define     WIDTH_TABLE_SIZE        256
+
+#define     BUCKET_MS(i)            (((i) << WIDTH_TABLE_SHIFT) + (1 << (WIDTH_TABLE_SHIFT - 1)))
+#define     IN_BAND(i, ms, margin)  ((BUCKET_MS(i) > ((ms) - (margin))) && (BUCKET_MS(i) < ((ms) + (margin))))
+
+// Classify a table bucket as a CARRIER_OFF width, CARRIER_ON width or CARRIER_ON offset from the cell start
+#define     OFF_WIDTH(i)            ( IN_BAND(i, 100, OFF_MARGIN_100) ? eWidth_100 :            \
+                                      IN_BAND(i, 200, OFF_MARGIN_200) ? eWidth_200 :            \
+                                      IN_BAND(i, 300, OFF_MARGIN_300) ? eWidth_300 :            \
+                                      IN_BAND(i, 500, OFF_MARGIN_500) ? eWidth_500 : eWidth_INVALID )
+
+#define     ON_WIDTH(i)             ( IN_BAND(i, 100, ON_MARGIN_100) ? eWidth_100 :             \
+                                      IN_BAND(i, 500, ON_MARGIN_500) ? eWidth_500 :             \
+                                      IN_BAND(i, 700, ON_MARGIN_700) ? eWidth_700 :             \
+                                      IN_BAND(i, 800, ON_MARGIN_800) ? eWidth_800 :             \
+                                      IN_BAND(i, 900, ON_MARGIN_900) ? eWidth_900 : eWidth_INVALID )
+
+#define     CELL_OFFSET(i)          ( IN_BAND(i, 100, OFFSET_MARGIN_100) ? eWidth_100 :         \
+                                      IN_BAND(i, 200, OFFSET_MARGIN_200) ? eWidth_200 :         \
+                                      IN_BAND(i, 300, OFFSET_MARGIN_300) ? eWidth_300 :         \
+                                      IN_BAND(i, 500, OFFSET_MARGIN_500) ? eWidth_500 : eWidth_INVALID )
+
+// Expand a classifier macro over all the table entries
+#define     WIDTH_ROW4(f, i)        f(i), f((i) + 1), f((i) + 2), f((i) + 3)
+#define     WIDTH_ROW16(f, i)       WIDTH_ROW4(f, i),  WIDTH_ROW4(f, (i) + 4),  WIDTH_ROW4(f, (i) + 8),  WIDTH_ROW4(f, (i) + 12)
+#define     WIDTH_ROW64(f, i)       WIDTH_ROW16(f, i), WIDTH_ROW16(f, (i) + 16), WIDTH_ROW16(f, (i) + 32), WIDTH_ROW16(f, (i) + 48)
+#define     WIDTH_TABLE(f)          { WIDTH_ROW64(f, 0), WIDTH_ROW64(f, 64), WIDTH_ROW64(f, 128), WIDTH_ROW64(f, 192) }
+
+// Only the hard engine classifies widths, the soft engine scores whole cells
+#if (MSF_DECODER_ENGINE == MSF_ENGINE_HARD)
+STATIC const uint8_t OffWidthTable[ WIDTH_TABLE_SIZE ]   = WIDTH_TABLE( OFF_WIDTH );
+STATIC const uint8_t OnWidthTable[ WIDTH_TABLE_SIZE ]    = WIDTH_TABLE( ON_WIDTH );
+STATIC const uint8_t CellOffsetTable[ WIDTH_TABLE_SIZE ] = WIDTH_TABLE( CELL_OFFSET );
+#endif
 
 
 
@@ -88,17 +260,246 @@ extern volatile uint32_t g_msSysTick;
  *      LOCAL STATIC VARIABLES
  ************************************************************************************************************/
 
-// Radio signal SYNC has been detected & locked
-STATIC bool bSyncedFlag = false;
+#if (MSF_VOTE_FRAMES > 0)
 
+// A received frame, the cells it lost and the second count at the start of its minute marker
+typedef struct {
+    uint64_t    A_bits;
+    uint64_t    B_bits;
+    uint64_t    Erased;
+    uint32_t    second;
+} sVoteFrame;
 
-// Each array needs to hold at least 59 bits. b0 is not used, numbering starts @ b1 to match the spec
-STATIC uint8_t A_bits[8];
-STATIC uint8_t B_bits[8];
+#endif
 
 
-// Local variable to save a valid date/time decode result.
-STATIC sMSFDateTime  LocalDateTime = { 0 };         // Local decoded date/time
+/**
+ * Everything the decoder knows about one receiver. The engines, the clock and the
+ * drift estimate only ever work through a pointer to one of these, so each radio
+ * is decoded independently of the others.
+ */
+typedef struct {
+
+    // Flags, kept together so they pack into one word with MSF_PACKED_STATE, then the 64 bit frame words
+    FLAG( bSyncedFlag );                            // Radio signal SYNC has been detected & locked
+    FLAG( bClockValid );                            // The free running clock below has been set
+    FLAG( bCandidate );                             // A frame is waiting to be confirmed, see CandidateSeconds
+    FLAG( bDriftValid );                            // DriftPpb has been measured
+#if (MSF_GLITCH_FILTER_MS > 0)
+    FLAG( bFilterPending );                         // FilterPending holds an edge
+#endif
+#if (MSF_DECODER_ENGINE == MSF_ENGINE_HARD)
+    FLAG( bPhaseLocked );                           // Tracking the second markers
+    FLAG( bHalfSync );                              // 500ms CARRIER_OFF detected
+    FLAG( bCellError );                             // Current cell is corrupt, skip to the next second marker
+    FLAG( bCellA );                                 // A & B bits of the current cell
+    FLAG( bCellB );
+#endif
+#if (MSF_DECODER_ENGINE == MSF_ENGINE_SOFT)
+    FLAG( bSoftPhaseLocked );                       // Tracking the second markers
+#endif
+#if (MSF_VOTE_FRAMES > 0)
+    FLAG( bVoteCounting );                          // VoteSeconds is counting the second markers
+#endif
+
+    // Lowest bit confidence (0-100) in the last frame decoded. The hard decision engine is always certain.
+    uint8_t     FrameConfidence;
+
+    // Each word needs to hold at least 59 bits. b0 is not used, numbering starts @ b1 to match the spec
+    uint64_t    A_bits;
+    uint64_t    B_bits;
+
+    // Local variable to save a valid date/time decode result.
+    sMSFDateTime LocalDateTime;
+
+    /**
+     * Single producer/single consumer queue of carrier edges. The radio ISR is the
+     * producer and MSF_Process() the consumer so no interrupt masking is needed.
+     */
+    uint8_t     EdgeQueueBuffer[ MSF_EDGE_QUEUE_SIZE * sizeof(sEdgeEvent) ];
+    sRingBuffer EdgeQueue;
+
+    // Count of edges discarded by the ISR because the queue was full, and the count it last queued a CARRIER_EDGES_LOST for
+    volatile uint32_t EdgeOverflowCount;
+    uint32_t    QueuedOverflowCount;
+
+    // Earliest tick count the next carrier edge can arrive, for low power clients
+    uint32_t    T_NextEdgeDeadline;
+
+    /**
+     * Free running clock. ClockSeconds is the time at tick count T_ClockSecond, which is the
+     * last second marker received, or a whole number of seconds after it while in holdover.
+     */
+    uint32_t    ClockSeconds;
+    uint32_t    T_ClockSecond;
+    uint32_t    nClockHoldover;                     // Seconds T_ClockSecond has been advanced without a second marker
+
+    /**
+     * Unix time is ClockSeconds + ClockUnixOffset, which is set from the DST bit (B58) of each
+     * frame. If the summer time warning (B53) is set the change is due at the next 01:00 UTC,
+     * which is ClockDstChange in Unix time, so the clock changes in holdover too. 0 if none is due.
+     */
+    uint32_t    ClockUnixOffset;
+    uint32_t    ClockDstChange;
+
+    /**
+     * Frame plausibility. nMinuteMarkers counts the minute markers while SYNC'd. A frame the
+     * clock didn't predict is the candidate until the next frame confirms it or replaces it.
+     */
+    uint32_t    nMinuteMarkers;
+    uint32_t    CandidateSeconds;               // Unix time
+    uint32_t    CandidateMinute;                // nMinuteMarkers when it was received
+
+    /**
+     * Local oscillator drift. Each second marker is a point (x seconds, y us) where y is the phase
+     * error accumulated since the start of the block, assuming a perfect oscillator. DriftY is
+     * kept in ticks. The running
+     * sums give the least squares slope, in us per second or ppm, at the end of the block.
+     */
+    int32_t     DriftPpb;                           // Parts per billion, +ve when the local oscillator is fast
+#if (MSF_MEASURE_DRIFT == 1)
+    int64_t     DriftSumX;
+    int64_t     DriftSumY;
+    int64_t     DriftSumXX;
+    int64_t     DriftSumXY;
+    uint32_t    nDriftMarkers;
+    int32_t     DriftX;
+    int32_t     DriftY;
+
+    int32_t     DriftTicksQ16;                      // The same as extra ticks per second, 16.16 fixed point
+    uint32_t    DriftRemainderQ16;                  // Fraction of a tick carried between holdover steps
+#endif
+
+#if (MSF_VOTE_FRAMES > 0)
+    // Ring of the most recent frames, all received since the decoder last lost count of the seconds
+    sVoteFrame  VoteHistory[ MSF_VOTE_FRAMES ];
+
+    // Seconds since counting started, at tick count T_VoteSecond. It carries on through a reSYNC so frames either side line up.
+    uint32_t    VoteSeconds;
+    uint32_t    T_VoteSecond;
+
+    SMALL_COUNT nVoteFrames;
+#endif
+
+#if (MSF_GLITCH_FILTER_MS > 0)
+    /**
+     * Glitch filter between the edge queue and the decoder engine. The last edge out of the
+     * queue is held in FilterPending till the next one shows it wasn't the start of a spike.
+     * FilterLevel is the carrier level after the last edge passed to the engine.
+     */
+    sEdgeEvent  FilterPending;
+    uint32_t    FilterLevel;
+#endif
+
+#if (MSF_ADAPTIVE_MARGINS == 1)
+    /**
+     * Pulse width calibration, indexed by the level after the edge that ends the interval.
+     * AdaptBiasQ8 is how much later than nominal the receiver reports CARRIER_ON edges, relative
+     * to CARRIER_OFF edges, and AdaptSpreadQ8 the mean absolute deviation of the corrected widths.
+     * Both are in ms scaled by 256. The interval errors of the frame being received are summed
+     * in AdaptSum and learned from if it passes validation.
+     */
+    int32_t     AdaptBiasQ8;
+    int32_t     AdaptSpreadQ8[ 2 ];
+    uint32_t    AdaptMargin[ 2 ];                   // ms, from the spread once nAdaptFrames reaches ADAPT_MIN_FRAMES
+    uint32_t    nAdaptFrames;
+    int32_t     AdaptSum[ 2 ];
+    uint32_t    AdaptAbsSum[ 2 ];
+    uint32_t    nAdaptIntervals[ 2 ];
+#endif
+
+#if (MSF_DETECT_POLARITY == 1)
+    /**
+     * Receiver output polarity. PolarityInvert is XOR'd into every edge level. PolarityScore
+     * goes up for each long CARRIER_OFF pulse and down for each long CARRIER_ON pulse.
+     */
+    uint32_t    PolarityInvert;
+    int32_t     PolarityScore;
+    uint32_t    T_PolarityEdge;
+#endif
+
+#if (MSF_ENABLE_QUALITY == 1)
+    /**
+     * Signal quality for MSF_GetSignalQuality(). Exponential averages scaled by 256 of how far
+     * each edge is from nominal, how many are in margin, the parity groups failed per frame
+     * and the lock quality, which is updated once a second at T_QualitySecond.
+     */
+    int32_t     QualityErrorQ8;                     // ms
+    int32_t     QualityInMarginQ8;                  // %
+    int32_t     QualityParityQ8;                    // Groups per frame
+    int32_t     QualityLockQ8;                      // 0-100
+    uint32_t    T_QualitySecond;
+    uint32_t    QualityHistogram[ MSF_QUALITY_ERROR_BINS ];
+#endif
+
+#if (MSF_DECODER_ENGINE == MSF_ENGINE_HARD)
+    /**
+     * Hard decision decoder state. Once the 1 Hz phase is found each completed cell is shifted
+     * into the A, B and erased shift registers, the most recent cell in bit 0. A corrupt cell is
+     * marked as erased rather than abandoning the frame, and the frame is picked out of the shift
+     * registers at the minute marker.
+     */
+    uint64_t    CellShiftA;
+    uint64_t    CellShiftB;
+    uint64_t    CellShiftErased;
+
+    uint32_t    T_CellStart;
+    uint32_t    T_MinuteStart;                      // Start of the minute marker cell
+
+    // Start and classified width of the last CARRIER_ON and CARRIER_OFF pulses
+    uint32_t    T_LastOnStart;
+    uint32_t    T_LastOffStart;
+    SMALL_ENUM( eWidth ) eLastOnWidth;
+    SMALL_ENUM( eWidth ) eLastOffWidth;
+
+    SMALL_COUNT nBitNum;                            // Bit number of the current cell 1 - 59, 60 for the minute marker, 0 if not yet known
+#endif
+
+#if (MSF_DECODER_ENGINE == MSF_ENGINE_SOFT)
+    /**
+     * Soft decision decoder state. A cell starts with the CARRIER_OFF second marker and
+     * the edges in it are recorded relative to the cell start until the next marker.
+     */
+    uint32_t    T_SoftCellStart;
+    uint32_t    SoftCellStartLevel;
+    uint16_t    SoftCellEdgeOffset[ SOFT_MAX_CELL_EDGES ];
+    uint8_t     SoftCellEdgeLevel[ SOFT_MAX_CELL_EDGES ];
+
+    uint32_t    T_SoftOffHistory[ SOFT_OFF_HISTORY ];   // Recent CARRIER_OFF edges while looking for the 1 Hz phase
+
+    // Confidence in each received A and B bit, indexed by bit number
+    uint8_t     SoftConfA[ 64 ];
+    uint8_t     SoftConfB[ 64 ];
+
+    SMALL_COUNT nSoftCellEdges;
+    SMALL_COUNT nSoftOffHistory;                    // Wraps, but always in step with T_SoftOffHistory[]
+    SMALL_COUNT nSoftBitNum;                        // Bit number of the current cell 1 - 59, 0 if not yet known
+    SMALL_COUNT nSoftBadCells;
+    SMALL_COUNT nSoftMissedMarkers;
+#endif
+
+#if (MSF_ENABLE_STATS == 1)
+    // Decoder statistics for MSF_GetStats(). RadioIsr & Edges are written by the radio ISR, the rest by MSF_Process().
+    sMSFStats   Stats;
+#endif
+
+} sReceiver;
+
+
+// One per radio, the index is the receiver number passed to MSF_QueueCarrierEdge()
+STATIC sReceiver Receivers[ MSF_NUM_RECEIVERS ];
+
+// The receiver MSF_GetTime(), MSF_GetClockDrift() and MSF_GetDecodeConfidence() report on
+STATIC sReceiver* pLeadRx = &Receivers[ 0 ];
+
+// The last minute passed to the client and the receiver that decoded it, so a minute
+// decoded by several receivers is only reported once
+STATIC sMSFDateTime FleetDateTime = { 0 };
+STATIC sReceiver*   pFleetRx = NULL;
+
+// Some receiver has SYNC, the client is told when this changes
+STATIC bool bFleetSynced = false;
+
 
 // Client supplied pointer to a date/time buffer
 STATIC sMSFDateTime* pClientDateTime = NULL;
@@ -110,12 +511,80 @@ STATIC MSF_EVENT_CALLBACK pfClientEventCallback = NULL;
 STATIC uint32_t ui32ClientEventMask = 0;
 
 
+#if (MSF_EVENT_QUEUE_SIZE > 0)
+
+/**
+ * Client events queued by MSF_Process() for MSF_DispatchEvents(). The queue has one producer
+ * and one consumer so the two can run in different tasks. A SYNC_LOST too recent to deliver
+ * yet is held by MSF_DispatchEvents() in HeldEvent.
+ */
+STATIC uint8_t           EventQueueBuffer[ MSF_EVENT_QUEUE_SIZE * sizeof(sClientEvent) ];
+STATIC sRingBuffer       EventQueue = RING_BUFFER_INIT( EventQueueBuffer );
+STATIC volatile uint32_t EventOverflowCount = 0;           // Only written by MSF_Process()
+STATIC uint32_t          LoggedOverflowCount = 0;          // Only written by MSF_DispatchEvents()
+STATIC bool              bEventHeld = false;
+STATIC sClientEvent      HeldEvent;
+
+#endif
+
+/**
+ * Date/time snapshot for MSF_ReadDateTime(). The last decoded minute is DateTimeSnapshot[ (n >> 1) & 1 ]
+ * where n is DateTimeGeneration, which is incremented to odd before the other buffer is written
+ * and to even once it's published. A reader copying one buffer can only be torn if the writer
+ * starts on that same buffer, two increments later.
+ *
+ * MSF_ReadDateTime() can run in any context, so the snapshot must be written and read in order
+ * with the generation count. Both are volatile so every compiler keeps them in order, without
+ * relying on a compiler specific barrier.
+ */
+STATIC volatile sMSFDateTime DateTimeSnapshot[ 2 ];
+STATIC volatile uint32_t     DateTimeGeneration = 0;
+
+// Local oscillator ticks per second, the same for every receiver
+STATIC uint32_t ClockTicksPerSecond = 1000;
+
+
+#if (HW_ENABLE_CAPTURE_TIMER == 1)
+
+// Number of capture timer ticks per millisecond
+STATIC uint32_t ui32TicksPerMs = 1;
+
+#endif
+
+
 
 /************************************************************************************************************
  *      LOCAL STATIC FUNCTION PROTOTYPES
  ************************************************************************************************************/
 
-STATIC void InitRadioInterface( void );
+STATIC void DecodeCarrierEvent( sReceiver* pRx, uint32_t event_level, uint32_t event_time );
+STATIC void ClockHoldover( sReceiver* pRx, uint32_t now );
+#if (MSF_VOTE_FRAMES > 0)
+STATIC void VoteSecondMarker( sReceiver* pRx, uint32_t event_time );
+STATIC void VoteHoldover( sReceiver* pRx, uint32_t now );
+#if (MSF_DECODER_ENGINE == MSF_ENGINE_HARD)
+STATIC bool HardRecoverFrame( sReceiver* pRx, uint64_t erased );
+#endif
+#endif
+STATIC uint32_t ProcessReceiver( sReceiver* pRx, uint32_t now );
+STATIC int32_t ReceiverWakeDeadline( sReceiver* pRx, uint32_t now );
+STATIC void SelectLeadReceiver( void );
+#if (MSF_ENABLE_QUALITY == 1)
+STATIC void QualitySecond( sReceiver* pRx, uint32_t now );
+#endif
+#if (MSF_DETECT_POLARITY == 1)
+STATIC bool CheckPolarity( sReceiver* pRx, sEdgeEvent* pEdge );
+#endif
+#if (MSF_ADAPTIVE_MARGINS == 1)
+STATIC void AdaptFrame( sReceiver* pRx, bool bGood );
+#endif
+#if (MSF_GLITCH_FILTER_MS > 0)
+STATIC void FilterCarrierEdge( sReceiver* pRx, const sEdgeEvent* pEdge );
+STATIC void ReleaseFilteredEdge( sReceiver* pRx );
+#endif
+#if (MSF_ENABLE_STATS == 1)
+STATIC void StatAddCycles( sMSFCycleStats* pSection, uint32_t start );
+#endif
 
 
 
@@ -142,15 +611,14 @@ STATIC void InitRadioInterface( void );
 *
 * NOTES
 *
-* Toggles a GPIO pin to control the radio. For Different hardware, edit
-* this function to do whatever's necessary to enable the MSF bit stream.
-* NB This pin is active low for my hardware.
+* Calls Radio_Enable() in radio.c. For different hardware, edit that to
+* do whatever's necessary to enable the MSF bit stream.
 *
 ********************************************************************/
 void
 MSF_EnableRadio( bool state )
 {
-    GPIOPinWrite(RADIO_PORT_BASE, RADIO_ENABLE_BIT, (state) ? 0 : RADIO_ENABLE_BIT );
+    Radio_Enable( state );
 }
 
 
@@ -163,7 +631,7 @@ MSF_EnableRadio( bool state )
 *       Initialises the MSF bit stream decoder
 *
 * PARAMETERS
-*       sMSFDateTime*       pdata       Buffer to receive the decoded date/time
+*       sMSFDateTime*       pdata       Buffer to receive the decoded date/time, or NULL
 *
 * OUTPUTS
 *       None
@@ -173,15 +641,58 @@ MSF_EnableRadio( bool state )
 *
 * NOTES
 *
+* pdata is updated by MSF_Process() with a plain copy, so it's only safe to
+* read from the same context. MSF_ReadDateTime() works from any context.
+*
 ********************************************************************/
 void
 MSF_InitDecoder( sMSFDateTime* pdata )
 {
+    sReceiver* pRx;
+    unsigned   receiver;
+
+    // Every receiver starts from reset, before the radio ISR can queue anything
+    for (receiver = 0 ; receiver < MSF_NUM_RECEIVERS ; receiver++)
+    {
+        pRx = &Receivers[ receiver ];
+        memset(pRx, 0, sizeof(sReceiver));
+
+        pRx->EdgeQueue.pBuffer  = pRx->EdgeQueueBuffer;
+        pRx->EdgeQueue.ui32Size = sizeof(pRx->EdgeQueueBuffer);
+        pRx->FrameConfidence    = SOFT_MAX_CONFIDENCE;
+#if (MSF_GLITCH_FILTER_MS > 0)
+        pRx->FilterLevel        = CARRIER_EDGES_LOST;
+#endif
+#if (MSF_DECODER_ENGINE == MSF_ENGINE_HARD)
+        pRx->CellShiftErased    = ~0ULL;
+#endif
+#if (MSF_DECODER_ENGINE == MSF_ENGINE_SOFT)
+        pRx->SoftCellStartLevel = CARRIER_OFF;
+#endif
+    }
+
+    pLeadRx      = &Receivers[ 0 ];
+    pFleetRx     = NULL;
+    bFleetSynced = false;
+
+#if (MSF_EVENT_QUEUE_SIZE > 0)
+    Ring_Consume( &EventQueue, Ring_Count(&EventQueue) );
+    bEventHeld = false;
+#endif
+
+    memset((void*) DateTimeSnapshot, 0, sizeof(DateTimeSnapshot));
+    DateTimeGeneration = 0;
+
     // A debug UART or LED can be optionally enabled in config.h <== really?
     Debug_InitUART();                   // Init one of the CPU UARTs if enabled
-    InitLED();                          // Optionally blink a LED when carrier changes
 
-    InitRadioInterface();
+    Radio_Init();                       // and the optional LED that shows the carrier
+
+#if (HW_ENABLE_CAPTURE_TIMER == 1)
+    ui32TicksPerMs = Radio_GetTicksPerMs();
+#endif
+
+    ClockTicksPerSecond = MS_TO_TICKS(CELL_LENGTH);
 
     // If the client supplied a valid data ptr, save it & initialise the struct
     if (pdata)
@@ -227,10 +738,10 @@ MSF_EnableEventNotifications( MSF_EVENT_CALLBACK pCallbackFunc, uint32_t enable_
 
 /*******************************************************************
 * NAME
-*       MSF_GetSyncState()
+*       MSF_DispatchEvents()
 *
 * DESCRIPTION
-*       Determine if the decoder is currently SYNC'd to a valid MSF60 bit stream.
+*       Deliver the queued event notifications to the client.
 *
 * PARAMETERS
 *       None
@@ -239,364 +750,2558 @@ MSF_EnableEventNotifications( MSF_EVENT_CALLBACK pCallbackFunc, uint32_t enable_
 *       None
 *
 * RETURNS
-*       bool            true    Decoder is SYNC'd to a valid date/time bit stream
-*                       false   Decoder is not currently SYNC'd
+*       uint32_t        Number of events delivered
 *
 * NOTES
 *
+* Call after MSF_Process(), from the main loop or from an RTOS task woken
+* by MSF_EVENT_QUEUED_HOOK() in config.h. The event handler runs here, in
+* the caller's context, so it can take as long as it likes. Only one task
+* may call it.
+*
+* Events queued since the last call are coalesced first: a repeated event
+* is delivered once, and a SYNC_LOST followed within MSF_EVENT_COALESCE_MS
+* by a SYNC is dropped. A SYNC_LOST is held back till it's that old, in
+* case the SYNC follows.
+*
+* With MSF_EVENT_QUEUE_SIZE 0 the events are delivered by MSF_Process()
+* as they happen and this does nothing.
+*
 ********************************************************************/
-bool
-MSF_GetSyncState( void )
-{
-    return bSyncedFlag;
-}
-
-
-
-
-
-
-/************************************************************************************************************
- *      PRIVATE LOCAL FUNCTIONS
- ************************************************************************************************************/
-
-/**
- * If a callback function is registered, and this particular event type is
- * unmasked, notify the client.
- */
-STATIC void
-ClientEventNotify( eMSFEventType ev )
+uint32_t
+MSF_DispatchEvents( void )
 {
-    if ((pfClientEventCallback) && (ui32ClientEventMask & ev))
+#if (MSF_EVENT_QUEUE_SIZE > 0)
+    sClientEvent batch[ MSF_EVENT_QUEUE_SIZE + 1 ];
+    sClientEvent event;
+#if (MSF_ENABLE_STATS == 1)
+    sReceiver*   pRx;
+#endif
+    uint32_t     nQueued = Ring_Count(&EventQueue) / sizeof(sClientEvent);
+    uint32_t     nBatch = 0;
+    uint32_t     nLost;
+    uint32_t     index;
+
+    if (bEventHeld)
     {
-        pfClientEventCallback( ev );
-    }
-}
-
-
-
-/**
- * Set or clear a bit in the A or B array
- */
-STATIC void
-setBit(uint8_t* bitarray, unsigned bitnum, bool bSet)
-{
-  uint8_t mask = 1 << (bitnum & 0x7);
-
-  if (bSet)
-      bitarray[ bitnum>>3 ] |= mask;
-  else
-      bitarray[ bitnum>>3 ] &= ~mask;
-}
-
-
-
-/**
- * Read a bit from the A or B arrays
- */
-STATIC bool
-getBit(uint8_t* bitarray, unsigned bitnum)
-{
-  uint8_t mask = 1 << (bitnum & 0x7);
-
-  return bitarray[ bitnum>>3 ] & mask;
-}
-
-
-
-/**
- * Extracts & decodes a BCD bitfield from the A or B data stream
- */
-STATIC uint8_t
-ExtractBCD( uint8_t *bitarray, uint8_t msbit, uint8_t lsbit  )
-{
-    static uint8_t BCD[] = { 1, 2, 4, 8, 10, 20, 40, 80 };
-
-    uint8_t result = 0;
-    uint8_t digit  = 0;
-    uint8_t bit;
-
-    for( bit = lsbit; bit >= msbit; bit--, digit++ )
-        if( getBit( bitarray, bit ))
-            result += BCD[ digit ];
-
-    return result;
-}
-
-
-
-/**
- * Check the specified bitfield along with the 'parity' parameter have ODD parity.
- */
-STATIC bool
-CheckOddParity(uint8_t *bitarray, int from, int to, bool parity)
-{
-unsigned numset = 0;
-unsigned bitnum;
-
-    for (bitnum = from ; bitnum <= to ; bitnum++)
-        if (getBit(bitarray, bitnum))
-            numset++;
-
-    if (parity)
-        numset++;
-
-    // Must be an odd number of set bits
-    return (numset & 1) ? true : false;
-}
-
-
-
-/**
- * Validate the received bit stream as per the NPL specification
- *
- */
-STATIC bool
-ValidateBCD()
-{
-unsigned bitnum;
-
-    // A52 must be 0
-    if (getBit( A_bits, 52)) {
-        LOGprintf(LOG_BCD_ERROR, "A52 is not zero!\n" );
-        return false;
+        batch[ nBatch++ ] = HeldEvent;
+        bEventHeld = false;
     }
 
-    // A53 through A58 must be 1
-    for(bitnum=53 ; bitnum<=58 ; bitnum++) {
-        if (!getBit( A_bits, bitnum)) {
-            LOGprintf(LOG_BCD_ERROR, "A%d is not set!\n", bitnum);
-            return false;
+    // Only the events queued so far, so a busy decoder can't keep us here
+    while ((nQueued-- > 0) && Ring_Get(&EventQueue, &event, sizeof(event)))
+    {
+        if ((nBatch > 0) && (batch[ nBatch - 1 ].type == event.type))
+        {
+            batch[ nBatch - 1 ] = event;
+        }
+        else if ((nBatch > 0) && (batch[ nBatch - 1 ].type == MSF_EVENT_SYNC_LOST) && (event.type == MSF_EVENT_SYNC) &&
+                 ((event.time - batch[ nBatch - 1 ].time) < MS_TO_TICKS(MSF_EVENT_COALESCE_MS)))
+        {
+            nBatch--;
+        }
+        else
+        {
+            batch[ nBatch++ ] = event;
         }
     }
 
-    // A59 must be 0
-    if (getBit( A_bits, 59)) {
-        LOGprintf(LOG_BCD_ERROR, "A59 is not zero!\n");
-        return false;
-    }
-
-    // A17 through A24 along with B54 must have odd parity
-    if (!CheckOddParity( A_bits, 17, 24, getBit(B_bits, 54))) {
-        LOGprintf(LOG_BCD_ERROR, "A17 to A24 fail parity check with B54!\n");
-        return false;
-    }
-
-    // A25 through A35 along with B55 must have odd parity
-    if (!CheckOddParity( A_bits, 25, 35, getBit(B_bits, 55)))  {
-        LOGprintf(LOG_BCD_ERROR, "A25 to A35 fail parity check with B55!\n");
-        return false;
+    // Hold back a SYNC_LOST that a SYNC could still cancel
+    if ((nBatch > 0) && (batch[ nBatch - 1 ].type == MSF_EVENT_SYNC_LOST) &&
+        ((Radio_GetTickCount() - batch[ nBatch - 1 ].time) < MS_TO_TICKS(MSF_EVENT_COALESCE_MS)))
+    {
+        HeldEvent  = batch[ --nBatch ];
+        bEventHeld = true;
     }
 
-    // A36 through A38 along with B56 must have odd parity
-    if (!CheckOddParity( A_bits, 36, 38, getBit(B_bits, 56)))  {
-        LOGprintf(LOG_BCD_ERROR, "A36 to A38 fail parity check with B55!\n");
-        return false;
+    // Each side only writes its own count, so MSF_Process() can overflow the queue meanwhile
+    nLost = EventOverflowCount - LoggedOverflowCount;
+    if (nLost)
+    {
+        LOGprintf(LOG_INFO, "%u client events lost\n", nLost);
+        LoggedOverflowCount += nLost;
     }
 
-    // A39 through A51 along with B57 must have odd parity
-    if (!CheckOddParity( A_bits, 39, 51, getBit(B_bits, 57))) {
-        LOGprintf(LOG_BCD_ERROR, "A39 to A51 fail parity check with B57!\n");
-        return false;
+    for (index = 0 ; (index < nBatch) && (pfClientEventCallback) ; index++)
+    {
+#if (MSF_ENABLE_STATS == 1)
+        pRx = &Receivers[ batch[ index ].receiver ];
+#endif
+        STAT_TIME( ClientCallback, pfClientEventCallback( (eMSFEventType) batch[ index ].type ) );
     }
 
-    return true;
+    return index;
+#else
+    return 0;
+#endif
 }
 
 
 
-/**
- * Once we have received a full frame of 59 bits try to decode it.
- * If it's valid & the client supplied a buffer, copy in the date/time.
- *
- */
-STATIC bool
-DecodeFrame()
+/*******************************************************************
+* NAME
+*       MSF_GetSyncState()
+*
+* DESCRIPTION
+*       Determine if the decoder is currently SYNC'd to a valid MSF60 bit stream.
+*
+* PARAMETERS
+*       None
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       bool            true    Decoder is SYNC'd to a valid date/time bit stream
+*                       false   Decoder is not currently SYNC'd
+*
+* NOTES
+*
+* With more than one receiver, true if any of them is SYNC'd.
+*
+********************************************************************/
+bool
+MSF_GetSyncState( void )
 {
+    return bFleetSynced;
+}
 
-    bool bFrameValid = ValidateBCD();
-    if (bFrameValid == true)
-    {
-        // Dump A and B bit buffers to the debug UART
-        LOGprintf(LOG_BIT_DUMP, "");
-
-        LocalDateTime.Year    = ExtractBCD( A_bits, 17, 24 );    // 0-99
-        LocalDateTime.Month   = ExtractBCD( A_bits, 25, 29 );    // 1-12
-        LocalDateTime.Day     = ExtractBCD( A_bits, 30, 35 );    // 1-31
-        LocalDateTime.DOW     = ExtractBCD( A_bits, 36, 38 );    // 0-6
-        LocalDateTime.Hour    = ExtractBCD( A_bits, 39, 44 );    // 0-23
-        LocalDateTime.Minute  = ExtractBCD( A_bits, 45, 51 );    // 0-59
-        LocalDateTime.DST     = ExtractBCD( B_bits, 58, 58 );    // 0 or 1
 
-        LocalDateTime.bHasValidTime    = true;
-        LocalDateTime.bDateTimeUpdated = true;
 
-        // Copy to the client's data struct if it's valid
-        if ((pClientDateTime) && (LocalDateTime.bHasValidTime))
-        {
-            *pClientDateTime = LocalDateTime;
-        }
+/*******************************************************************
+* NAME
+*       MSF_ReadDateTime()
+*
+* DESCRIPTION
+*       Read the last decoded date/time.
+*
+* PARAMETERS
+*       sMSFDateTime*   pDateTime   Buffer to receive the date/time
+*
+* OUTPUTS
+*       A consistent copy of the last minute decoded. bHasValidTime is
+*       false if nothing has been decoded yet.
+*
+* RETURNS
+*       uint32_t        Number of minutes decoded since MSF_InitDecoder(),
+*                       0 if none. It changes every time the date/time does.
+*
+* NOTES
+*
+* Safe from any task or interrupt handler. It never disables interrupts
+* and never waits for the decoder, which writes the other half of a double
+* buffer. A copy is only retried if two whole minutes are published while
+* it's being made.
+*
+* Poll it and compare the return value with the last one to see if the
+* time has changed, instead of polling bDateTimeUpdated.
+*
+********************************************************************/
+uint32_t
+MSF_ReadDateTime( sMSFDateTime* pDateTime )
+{
+    uint32_t generation;
 
-        // Notify the client
-        ClientEventNotify( MSF_EVENT_DATETIME_UPDATED );
-    }
+    do {
+        generation = DateTimeGeneration;
+        *pDateTime = DateTimeSnapshot[ (generation >> 1) & 1 ];
+    } while ((uint32_t)(DateTimeGeneration - (generation & ~1U)) > 2);
 
-    return bFrameValid;
+    return generation >> 1;
 }
 
 
 
-/**
- * Check for all possible CARRIER_ON & CARRIER_OFF pulse width we may encounter in a valid signal.
- *
- */
-STATIC eWidth
-GetWidth( uint32_t width )
-{
-    if (abs(width-100) < PULSE_MARGIN)
-        return eWidth_100;
-    else if (abs(width-200) < PULSE_MARGIN)
-        return eWidth_200;
-    else if (abs(width-300) < PULSE_MARGIN)
-        return eWidth_300;
-    else if (abs(width-500) < PULSE_MARGIN)
-        return eWidth_500;
-    else if (abs(width-700) < PULSE_MARGIN)
-        return eWidth_700;
-    else if (abs(width-800) < PULSE_MARGIN)
-        return eWidth_800;
-    else if (abs(width-900) < PULSE_MARGIN)
-        return eWidth_900;
-    else
-        return eWidth_INVALID;
+/*******************************************************************
+* NAME
+*       MSF_GetReceiverSyncState()
+*
+* DESCRIPTION
+*       Determine if one receiver is currently SYNC'd.
+*
+* PARAMETERS
+*       unsigned        receiver    0 to MSF_NUM_RECEIVERS - 1
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       bool            true    The receiver is SYNC'd to a valid date/time bit stream
+*                       false   Not SYNC'd, or there's no such receiver
+*
+* NOTES
+*
+********************************************************************/
+bool
+MSF_GetReceiverSyncState( unsigned receiver )
+{
+    return (receiver < MSF_NUM_RECEIVERS) ? Receivers[ receiver ].bSyncedFlag : false;
 }
 
 
 
 /*******************************************************************
-* NAME  HandleCarrierEvent
+* NAME
+*       MSF_GetLeadReceiver()
 *
 * DESCRIPTION
-*       Processes changes in the carrier signal from the radio
+*       Find out which receiver the free running clock is following.
 *
 * PARAMETERS
-*       uint32_t    event_level     CARRIER_ON or CARRIER_OFF GPIO pin level
+*       None
 *
 * OUTPUTS
-*       If a valid time is decoded it is copied to the users pUserDateTime
+*       None
 *
 * RETURNS
-*       Nothing
+*       unsigned        0 to MSF_NUM_RECEIVERS - 1
 *
 * NOTES
 *
-* 1. Wait for a valid SYNC condition, 500ms CARRIER_OFF then 500 ms CARRIER_ON then CARRIER_OFF
-* 2. Determine if the event_level & timing is valid for the current state
-* 3. Extract the A and B bits from each second/cell and save them.
-* 4. After 59 error-free seconds/cells, validate the received A & B bit stream.
-* 5. If the frame is valid, decode & save the date/time information.
-* 6. If the client registered a buffer, copy the date/time into it & set the update flag.
-* 7. If the client registered an event callback, notify the date/time has updated.
-*
-* If at any point an unexpected or impossible state or timing is detected, ditch the entire
-* frame and restart to SYNC the bit stream again.
+* The first receiver to decode a frame leads. If it loses the second
+* markers and goes into holdover, any receiver still locked to them
+* takes over. MSF_GetTime(), MSF_GetClockDrift() and
+* MSF_GetDecodeConfidence() all report on the lead receiver.
 *
-*/
-STATIC void
-HandleCarrierEvent(uint32_t event_level)
+********************************************************************/
+unsigned
+MSF_GetLeadReceiver( void )
 {
-static uint32_t T_LastOnStart  = 0;
-static uint32_t T_LastOffStart = 0;
-static eWidth eLastOnWidth  = eWidth_INVALID;
-static eWidth eLastOffWidth = eWidth_INVALID;
-static uint32_t T_CellStart = 0;
+    return (unsigned)(pLeadRx - Receivers);
+}
 
-static unsigned nBitNum = 1;            // Current bit number (ie second) being decoded 1 - 59
-static bool bHalfSync = false;          // 500ms CARRIER_OFF detected
-static bool bResyncNeeded = true;
 
-    uint32_t event_time = g_msSysTick;
 
-    switch (event_level)
-    {
-        case CARRIER_OFF:
-        {
-            // Update state tracking variables
-            T_LastOffStart = event_time;
-            eLastOnWidth   = GetWidth(event_time - T_LastOnStart);
+/*******************************************************************
+* NAME
+*       MSF_Process()
+*
+* DESCRIPTION
+*       Decode any carrier edges queued by the radio interrupt handler.
+*
+* PARAMETERS
+*       None
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       uint32_t        Number of queued edges processed
+*
+* NOTES
+*
+* Call this regularly from the main loop or an RTOS task, at least once
+* a second. The frame decode, client date/time update and client event
+* callbacks all run from here, in the caller's context.
+*
+* If the queue overflowed since the last call the decoder engine is told,
+* so it can drop the cells affected.
+*
+* Every receiver's queue is processed, the count is the total.
+*
+********************************************************************/
+uint32_t
+MSF_Process( void )
+{
+    uint32_t now = Radio_GetTickCount();
+    uint32_t nProcessed = 0;
+    unsigned receiver;
+
+    for (receiver = 0 ; receiver < MSF_NUM_RECEIVERS ; receiver++)
+        nProcessed += ProcessReceiver( &Receivers[ receiver ], now );
+
+    SelectLeadReceiver();
+
+    // Format any messages logged while decoding
+    LOG_Flush();
+
+    return nProcessed;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       MSF_GetWakeDeadline()
+*
+* DESCRIPTION
+*       Get the time until the next carrier edge can arrive from the radio.
+*
+* PARAMETERS
+*       None
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       uint32_t        Milliseconds until the earliest time the next edge
+*                       is expected. 0 if one may arrive at any moment.
+*
+* NOTES
+*
+* Call this after MSF_Process(). Each edge wakes the CPU through the radio
+* interrupt so it's always safe to SysCtlSleep() till the next interrupt.
+* The deadline tells a low power client how long it can spend in a deeper
+* sleep state, or with other wake up sources turned off, before the radio
+* interrupt must be serviced. It already allows for PULSE_MARGIN.
+*
+* Once SYNC'd only about 3 edges a second are expected and for most of each
+* second the deadline is several hundred milliseconds away.
+*
+* With more than one receiver it's the earliest of their deadlines.
+*
+********************************************************************/
+uint32_t
+MSF_GetWakeDeadline( void )
+{
+    uint32_t now = Radio_GetTickCount();
+    int32_t  remaining = ReceiverWakeDeadline( &Receivers[ 0 ], now );
+    int32_t  next;
+    unsigned receiver;
+
+    for (receiver = 1 ; receiver < MSF_NUM_RECEIVERS ; receiver++)
+    {
+        next = ReceiverWakeDeadline( &Receivers[ receiver ], now );
+        if (next < remaining)
+            remaining = next;
+    }
+
+    return (remaining > 0) ? (uint32_t) TICKS_TO_MS(remaining) : 0;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       MSF_GetDecodeConfidence()
+*
+* DESCRIPTION
+*       Get the confidence in the last date/time decoded.
+*
+* PARAMETERS
+*       None
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       uint8_t         0-100, the confidence of the least certain bit
+*                       in the last valid frame.
+*
+* NOTES
+*
+* Only the soft decision engine (see config.h) measures confidence, bits
+* decoded by the hard decision engine are always 100. Bits corrected by
+* the parity check contribute their confidence before correction. For a
+* frame voted from several (MSF_VOTE_FRAMES), it's how well the frames
+* agreed on the least certain bit.
+*
+* With more than one receiver it's the lead receiver's last frame.
+*
+********************************************************************/
+uint8_t
+MSF_GetDecodeConfidence( void )
+{
+    return pLeadRx->FrameConfidence;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       MSF_GetClockDrift()
+*
+* DESCRIPTION
+*       Get the measured error of the local oscillator.
+*
+* PARAMETERS
+*       int32_t*        pDriftPpb   Buffer to receive the error in parts per
+*                                   billion. Positive if the local clock is fast.
+*
+* OUTPUTS
+*       The oscillator error, if it has been measured.
+*
+* RETURNS
+*       bool            true    The error has been measured
+*                       false   Not enough second markers have been received yet
+*
+* NOTES
+*
+* The error is measured against the second markers over blocks of
+* DRIFT_BLOCK_SECONDS and smoothed across blocks. It's kept when SYNC is
+* lost and the free running clock uses it to correct itself in holdover.
+*
+* Divide by 1000 for ppm.
+*
+* With more than one receiver it's the lead receiver's measurement.
+* Always false with MSF_MEASURE_DRIFT 0.
+*
+********************************************************************/
+bool
+MSF_GetClockDrift( int32_t* pDriftPpb )
+{
+    *pDriftPpb = pLeadRx->DriftPpb;
+
+    return pLeadRx->bDriftValid;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       MSF_GetTime()
+*
+* DESCRIPTION
+*       Read the free running clock.
+*
+* PARAMETERS
+*       sMSFTime*       pTime       Buffer to receive the time
+*
+* OUTPUTS
+*       The time to the nearest millisecond, and how long the clock has
+*       been in holdover.
+*
+* RETURNS
+*       eMSFTimeQuality     MSF_TIME_INVALID until the first frame is decoded.
+*                           MSF_TIME_LOCKED while second markers are being received.
+*                           MSF_TIME_HOLDOVER once they've been missing for
+*                           CLOCK_HOLDOVER_SECONDS.
+*
+* NOTES
+*
+* The clock is set from every decoded frame and disciplined by every second
+* marker in between. It keeps running after SYNC is lost, so the time is
+* available throughout. Reading it is a couple of divisions, no calendar
+* arithmetic is done.
+*
+* UnixSeconds is UTC, BST is taken off using the DST bit of the last frame.
+* A change announced by the summer time warning bit is made on time even if
+* the frame after it isn't received. It's 32 bits so it's good until 2106.
+*
+* Call from the same context as MSF_Process().
+*
+* With more than one receiver this is the lead receiver's clock, see
+* MSF_GetLeadReceiver().
+*
+********************************************************************/
+eMSFTimeQuality
+MSF_GetTime( sMSFTime* pTime )
+{
+    sReceiver* pRx = pLeadRx;
+    uint32_t elapsed, seconds, ms;
+
+    if (!pRx->bClockValid)
+    {
+        memset(pTime, 0, sizeof(sMSFTime));
+        return MSF_TIME_INVALID;
+    }
+
+    elapsed = Radio_GetTickCount() - pRx->T_ClockSecond;
+    seconds = elapsed / ClockTicksPerSecond;
+    ms      = TICKS_TO_MS(elapsed - (seconds * ClockTicksPerSecond));
+
+    pTime->Seconds         = pRx->ClockSeconds + seconds;
+    pTime->UnixSeconds     = pTime->Seconds + pRx->ClockUnixOffset;
+    pTime->Milliseconds    = (ms < CELL_LENGTH) ? ms : (CELL_LENGTH - 1);
+    pTime->HoldoverSeconds = pRx->nClockHoldover + seconds;
+    pTime->Quality         = (pTime->HoldoverSeconds < CLOCK_HOLDOVER_SECONDS) ? MSF_TIME_LOCKED : MSF_TIME_HOLDOVER;
+
+    return (eMSFTimeQuality) pTime->Quality;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       MSF_GetStats()
+*
+* DESCRIPTION
+*       Read the decoder statistics.
+*
+* PARAMETERS
+*       sMSFStats*      pStats      Buffer to receive the statistics
+*
+* OUTPUTS
+*       The event counts and cycle counts since MSF_InitDecoder(). Zeroed
+*       if the statistics aren't enabled.
+*
+* RETURNS
+*       bool            true    The statistics are valid
+*                       false   MSF_ENABLE_STATS is 0 in config.h
+*
+* NOTES
+*
+* The cycle counts are from the DWT cycle counter, so they're in system
+* clock cycles and include any time spent in higher priority interrupts.
+* The mean of a section is TotalCycles / Count.
+*
+* With more than one receiver these are receiver 0's statistics, see
+* MSF_GetReceiverStats().
+*
+********************************************************************/
+bool
+MSF_GetStats( sMSFStats* pStats )
+{
+    return MSF_GetReceiverStats( 0, pStats );
+}
+
+
+
+/*******************************************************************
+* NAME
+*       MSF_GetReceiverStats()
+*
+* DESCRIPTION
+*       Read the decoder statistics for one receiver.
+*
+* PARAMETERS
+*       unsigned        receiver    0 to MSF_NUM_RECEIVERS - 1
+*       sMSFStats*      pStats      Buffer to receive the statistics
+*
+* OUTPUTS
+*       As MSF_GetStats(). Zeroed if there's no such receiver.
+*
+* RETURNS
+*       bool            true    The statistics are valid
+*                       false   MSF_ENABLE_STATS is 0 in config.h, or there's
+*                               no such receiver
+*
+* NOTES
+*
+********************************************************************/
+bool
+MSF_GetReceiverStats( unsigned receiver, sMSFStats* pStats )
+{
+#if (MSF_ENABLE_STATS == 1)
+    sReceiver* pRx;
+    uint32_t   mask;
+
+    if (receiver < MSF_NUM_RECEIVERS)
+    {
+        pRx = &Receivers[ receiver ];
+
+        // The radio ISR updates some of the counts
+        mask = Radio_IntDisable();
+
+        *pStats = pRx->Stats;
+        pStats->EdgesLost = pRx->EdgeOverflowCount;
+
+        Radio_IntRestore( mask );
+
+        return true;
+    }
+#else
+    (void) receiver;
+#endif
+
+    memset(pStats, 0, sizeof(sMSFStats));
+    return false;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       MSF_GetSignalQuality()
+*
+* DESCRIPTION
+*       Read the signal quality measurements of one receiver.
+*
+* PARAMETERS
+*       unsigned            receiver    0 to MSF_NUM_RECEIVERS - 1
+*       sMSFSignalQuality*  pQuality    Buffer to receive the measurements
+*
+* OUTPUTS
+*       The running measurements, see sMSFSignalQuality. Zeroed if they
+*       aren't enabled or there's no such receiver.
+*
+* RETURNS
+*       bool            true    The measurements are valid
+*                       false   MSF_ENABLE_QUALITY is 0 in config.h, or
+*                               there's no such receiver
+*
+* NOTES
+*
+* The measurements are kept up to date as the edges are decoded, so this
+* is only a copy. Call from the same context as MSF_Process().
+*
+* The lock quality is what picks the receiver MSF_GetTime() follows when
+* the lead receiver loses the second markers.
+*
+********************************************************************/
+bool
+MSF_GetSignalQuality( unsigned receiver, sMSFSignalQuality* pQuality )
+{
+#if (MSF_ENABLE_QUALITY == 1)
+    sReceiver* pRx;
+    uint32_t   ber;
+
+    if (receiver < MSF_NUM_RECEIVERS)
+    {
+        pRx = &Receivers[ receiver ];
+        ber = ((uint32_t) pRx->QualityParityQ8 * 1000) / (QUALITY_PARITY_BITS << 8);
+
+        pQuality->LockQuality       = (uint8_t)((pRx->QualityLockQ8 + 128) >> 8);
+        pQuality->EdgesInMargin     = (uint8_t)((pRx->QualityInMarginQ8 + 128) >> 8);
+        pQuality->EdgeErrorUs       = (uint16_t)((pRx->QualityErrorQ8 * 1000) >> 8);
+        pQuality->BitErrorsPerMille = (uint16_t)((ber < 1000) ? ber : 1000);
+        memcpy(pQuality->ErrorHistogram, pRx->QualityHistogram, sizeof(pQuality->ErrorHistogram));
+
+#if (MSF_ADAPTIVE_MARGINS == 1)
+        pQuality->OnEdgeBiasMs = (int8_t)((pRx->AdaptBiasQ8 + 128) >> 8);
+        pQuality->MarginMs     = (uint8_t)((pRx->nAdaptFrames < ADAPT_MIN_FRAMES) ? PULSE_MARGIN : pRx->AdaptMargin[ CARRIER_ON ]);
+#else
+        pQuality->OnEdgeBiasMs = 0;
+        pQuality->MarginMs     = PULSE_MARGIN;
+#endif
+
+#if (MSF_DETECT_POLARITY == 1)
+        pQuality->bInverted    = (uint8_t) pRx->PolarityInvert;
+#else
+        pQuality->bInverted    = 0;
+#endif
+
+        return true;
+    }
+#else
+    (void) receiver;
+#endif
+
+    memset(pQuality, 0, sizeof(sMSFSignalQuality));
+    return false;
+}
+
+
+
+
+
+
+/************************************************************************************************************
+ *      PRIVATE LOCAL FUNCTIONS
+ ************************************************************************************************************/
+
+#if (MSF_ENABLE_STATS == 1)
+
+/**
+ * Add one run of a timed section, started at cycle count 'start', to its statistics
+ */
+STATIC void
+StatAddCycles( sMSFCycleStats* pSection, uint32_t start )
+{
+    uint32_t cycles = CYCLE_COUNT() - start;
+
+    if ((pSection->Count == 0) || (cycles < pSection->MinCycles))
+        pSection->MinCycles = cycles;
+
+    if (cycles > pSection->MaxCycles)
+        pSection->MaxCycles = cycles;
+
+    pSection->TotalCycles += cycles;
+    pSection->Count++;
+}
+
+#endif
+
+
+
+#if (MSF_GLITCH_FILTER_MS > 0)
+
+/**
+ * Pass the edge held by the glitch filter, if any, to the decoder engine
+ */
+STATIC void
+ReleaseFilteredEdge( sReceiver* pRx )
+{
+    if (pRx->bFilterPending)
+    {
+        pRx->bFilterPending = false;
+        pRx->FilterLevel    = pRx->FilterPending.level;
+
+        STAT_TIME( CarrierEvent, DecodeCarrierEvent( pRx, pRx->FilterPending.level, pRx->FilterPending.time ) );
+    }
+}
+
+
+
+/**
+ * Glitch filter. An edge that doesn't change the carrier level is merged into the one
+ * before it. A pulse shorter than MSF_GLITCH_FILTER_MS is a spike so the edges at both
+ * ends of it are dropped. Anything else releases the edge held and is held in its place.
+ */
+STATIC void
+FilterCarrierEdge( sReceiver* pRx, const sEdgeEvent* pEdge )
+{
+    uint32_t level = (pRx->bFilterPending) ? pRx->FilterPending.level : pRx->FilterLevel;
+
+    if (pEdge->level == level)
+    {
+        STAT_INC( EdgesMerged );
+        return;
+    }
+
+    if (pRx->bFilterPending && ((pEdge->time - pRx->FilterPending.time) < MS_TO_TICKS(MSF_GLITCH_FILTER_MS)))
+    {
+        pRx->bFilterPending = false;
+        STAT_INC( GlitchesRejected );
+        return;
+    }
+
+    ReleaseFilteredEdge( pRx );
+
+    pRx->FilterPending  = *pEdge;
+    pRx->bFilterPending = true;
+}
+
+#endif
+
+
+
+/**
+ * Tell the decoder engine the edges can't be trusted, so it starts again from the next one
+ */
+STATIC void
+LoseEdges( sReceiver* pRx )
+{
+#if (MSF_GLITCH_FILTER_MS > 0)
+    ReleaseFilteredEdge( pRx );
+    pRx->FilterLevel = CARRIER_EDGES_LOST;
+#endif
+    DecodeCarrierEvent( pRx, CARRIER_EDGES_LOST, 0 );
+}
+
+
+
+#if (MSF_DETECT_POLARITY == 1)
+
+/**
+ * Put an edge the right way up. Every second but the minute marker has a 700 to 900ms
+ * CARRIER_ON pulse and the MSF signal never has one that long with the carrier OFF, so
+ * if long pulses keep ending at CARRIER_ON edges the receiver's output is inverted.
+ *
+ * Returns true if the polarity has just been changed.
+ */
+STATIC bool
+CheckPolarity( sReceiver* pRx, sEdgeEvent* pEdge )
+{
+uint32_t width = TICKS_TO_MS(pEdge->time - pRx->T_PolarityEdge);
+
+    if (pEdge->level > CARRIER_OFF)
+        return false;
+
+    pRx->T_PolarityEdge = pEdge->time;
+    pEdge->level ^= pRx->PolarityInvert;
+
+    if ((width < POLARITY_LONG_MIN) || (width > POLARITY_LONG_MAX))
+        return false;
+
+    // The pulse that's just ended was at the other level
+    if (pEdge->level == CARRIER_OFF)
+    {
+        if (pRx->PolarityScore > -POLARITY_VOTES)
+            pRx->PolarityScore--;
+        return false;
+    }
+
+    if (++pRx->PolarityScore < POLARITY_VOTES)
+        return false;
+
+    pRx->PolarityInvert ^= 1;
+    pRx->PolarityScore   = 0;
+    pEdge->level        ^= 1;
+
+    LOGprintf(LOG_INFO, "Receiver output %s\n", (pRx->PolarityInvert) ? "inverted" : "normal");
+    return true;
+}
+
+#endif
+
+
+
+/**
+ * Decode the edges one receiver has queued, see MSF_Process()
+ */
+STATIC uint32_t
+ProcessReceiver( sReceiver* pRx, uint32_t now )
+{
+    uint32_t nProcessed = 0;
+    uint32_t nQueued = Ring_Count(&pRx->EdgeQueue) / sizeof(sEdgeEvent);
+    sEdgeEvent edge;
+
+    // Only the edges queued so far, so a busy radio can't keep us here
+    while ((nProcessed < nQueued) && Ring_Get(&pRx->EdgeQueue, &edge, sizeof(edge)))
+    {
+        nProcessed++;
+
+        // Edges were dropped here so the frame can't be trusted
+        if (edge.level == CARRIER_EDGES_LOST)
+        {
+            LoseEdges( pRx );
+            continue;
+        }
+
+#if (MSF_DETECT_POLARITY == 1)
+        // The edges so far were the wrong way up
+        if (CheckPolarity( pRx, &edge ))
+            LoseEdges( pRx );
+#endif
+
+#if (MSF_GLITCH_FILTER_MS > 0)
+        FilterCarrierEdge( pRx, &edge );
+#else
+        STAT_TIME( CarrierEvent, DecodeCarrierEvent( pRx, edge.level, edge.time ) );
+#endif
+    }
+
+#if (MSF_GLITCH_FILTER_MS > 0)
+    // Any edge ending a spike would have been queued by the time we started
+    if (pRx->bFilterPending && ((int32_t)(now - pRx->FilterPending.time) >= (int32_t) MS_TO_TICKS(MSF_GLITCH_FILTER_MS)))
+        ReleaseFilteredEdge( pRx );
+#endif
+
+    // Keep the clock running through any gap in the second markers
+    ClockHoldover( pRx, now );
+#if (MSF_VOTE_FRAMES > 0)
+    VoteHoldover( pRx, now );
+#endif
+
+#if (MSF_ENABLE_QUALITY == 1)
+    QualitySecond( pRx, now );
+#endif
+
+    return nProcessed;
+}
+
+
+
+/**
+ * Ticks until the next edge can arrive at one receiver, see MSF_GetWakeDeadline()
+ */
+STATIC int32_t
+ReceiverWakeDeadline( sReceiver* pRx, uint32_t now )
+{
+    // Edges waiting to be processed means there's work to do right now
+    if (Ring_Count(&pRx->EdgeQueue) != 0)
+        return 0;
+
+#if (MSF_GLITCH_FILTER_MS > 0)
+    // An edge held by the glitch filter must be passed on as soon as it's old enough
+    if (pRx->bFilterPending)
+        return (int32_t)(pRx->FilterPending.time + MS_TO_TICKS(MSF_GLITCH_FILTER_MS) - now);
+#endif
+
+    return (int32_t)(pRx->T_NextEdgeDeadline - now);
+}
+
+
+
+/**
+ * Hand the free running clock to a receiver that's still locked to the second
+ * markers if the lead receiver has lost them, the one with the best signal if
+ * more than one is
+ */
+STATIC void
+SelectLeadReceiver( void )
+{
+    sReceiver* pBest = NULL;
+    unsigned   receiver;
+
+    if ((pLeadRx->bClockValid) && (pLeadRx->nClockHoldover < CLOCK_HOLDOVER_SECONDS))
+        return;
+
+    for (receiver = 0 ; receiver < MSF_NUM_RECEIVERS ; receiver++)
+    {
+        if ((Receivers[ receiver ].bClockValid) && (Receivers[ receiver ].nClockHoldover == 0))
+        {
+#if (MSF_ENABLE_QUALITY == 1)
+            if ((pBest) && (Receivers[ receiver ].QualityLockQ8 <= pBest->QualityLockQ8))
+                continue;
+#else
+            if (pBest)
+                break;
+#endif
+            pBest = &Receivers[ receiver ];
+        }
+    }
+
+    if (pBest)
+    {
+        pLeadRx = pBest;
+        LOGprintf(LOG_INFO, "Receiver %u leads\n", (unsigned)(pBest - Receivers));
+    }
+}
+
+
+
+/**
+ * If a callback function is registered, and this particular event type is
+ * unmasked, notify the client. With the event queue it's queued for
+ * MSF_DispatchEvents().
+ */
+STATIC void
+ClientEventNotify( sReceiver* pRx, eMSFEventType ev )
+{
+#if (MSF_EVENT_QUEUE_SIZE > 0)
+    sClientEvent event;
+#endif
+
+    if ((pfClientEventCallback) && (ui32ClientEventMask & ev))
+    {
+#if (MSF_EVENT_QUEUE_SIZE > 0)
+        event.time     = Radio_GetTickCount();
+        event.type     = (uint16_t) ev;
+        event.receiver = (uint16_t)(pRx - Receivers);
+
+        if (Ring_Put(&EventQueue, &event, sizeof(event)))
+            MSF_EVENT_QUEUED_HOOK();
+        else
+            EventOverflowCount++;
+#else
+        (void) pRx;                                 // Only the stats need it
+        STAT_TIME( ClientCallback, pfClientEventCallback( ev ) );
+#endif
+    }
+}
+
+
+
+/**
+ * Set a receiver's SYNC flag. The client gets MSF_EVENT_SYNC every time a receiver
+ * SYNCs but MSF_EVENT_SYNC_LOST only when the last one loses it.
+ */
+STATIC void
+SetSyncState( sReceiver* pRx, bool bSynced )
+{
+    bool     bAnySynced = false;
+    unsigned receiver;
+
+    pRx->bSyncedFlag = bSynced;
+
+    // Without SYNC the minutes since the candidate frame aren't being counted
+    if (!bSynced)
+        pRx->bCandidate = false;
+
+    for (receiver = 0 ; receiver < MSF_NUM_RECEIVERS ; receiver++)
+        bAnySynced |= Receivers[ receiver ].bSyncedFlag;
+
+    if (bSynced)
+        ClientEventNotify( pRx, MSF_EVENT_SYNC );
+    else if (bFleetSynced && !bAnySynced)
+        ClientEventNotify( pRx, MSF_EVENT_SYNC_LOST );
+
+    bFleetSynced = bAnySynced;
+}
+
+
+
+/**
+ * Set or clear a bit in the A or B word
+ */
+STATIC void
+setBit(uint64_t* pFrame, unsigned bitnum, bool bSet)
+{
+  uint64_t mask = FRAME_BIT(bitnum & 0x3F);
+
+  if (bSet)
+      *pFrame |= mask;
+  else
+      *pFrame &= ~mask;
+}
+
+
+
+#if (MSF_DECODER_ENGINE == MSF_ENGINE_SOFT)
+/**
+ * Read a bit from the A or B words
+ */
+STATIC bool
+getBit(uint64_t frame, unsigned bitnum)
+{
+  return (frame & FRAME_BIT(bitnum & 0x3F)) ? true : false;
+}
+#endif
+
+
+
+/**
+ * Convert a BCD field extracted with FRAME_FIELD() to binary
+ */
+STATIC uint8_t
+BCDToBinary( uint32_t bcd )
+{
+    return (uint8_t)(((bcd >> 4) * 10) + (bcd & 0x0F));
+}
+
+
+
+/**
+ * Check the bits set in 'bits' have ODD parity. The word is folded down
+ * to a nibble then looked up in a 16 bit parity table.
+ */
+STATIC bool
+CheckOddParity( uint64_t bits )
+{
+    uint32_t fold = (uint32_t)(bits >> 32) ^ (uint32_t) bits;
+
+    fold ^= fold >> 16;
+    fold ^= fold >> 8;
+    fold ^= fold >> 4;
+
+    return (0x6996 >> (fold & 0x0F)) & 1;
+}
+
+
+
+// Days in the year before the start of each month, not counting Feb 29th
+STATIC const uint16_t DaysBeforeMonth[ 12 ] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+
+
+
+/**
+ * Days since 1st Jan 2000 of a date that's been range checked. Years 2000-2099, every 4th is a leap year.
+ */
+STATIC uint32_t
+DaysSince2000( uint32_t year, uint32_t month, uint32_t day )
+{
+uint32_t days = (year * 365) + ((year + 3) / 4) + DaysBeforeMonth[ month - 1 ] + (day - 1);
+
+    if (((year % 4) == 0) && (month > 2))
+        days++;
+
+    return days;
+}
+
+
+
+/**
+ * Decode DUT1 from B1 to B16. Each of B1 to B8 that's set adds 0.1 s and each of B9 to B16
+ * takes 0.1 s off, filled from the first bit of the group. They aren't covered by parity, so
+ * any other pattern, or bits set in both groups, is an error.
+ */
+STATIC bool
+DecodeDUT1( uint64_t B_bits, int8_t* pDUT1 )
+{
+uint32_t positive = FRAME_FIELD( B_bits, 1, 8 );
+uint32_t negative = FRAME_FIELD( B_bits, 9, 16 );
+uint32_t run = (positive) ? positive : negative;
+int8_t   tenths = 0;
+
+    if (positive && negative)
+        return false;
+
+    for ( ; run & 0x80 ; run = (run << 1) & 0xFF)
+        tenths++;
+
+    if (run)
+        return false;
+
+    *pDUT1 = (positive) ? tenths : -tenths;
+    return true;
+}
+
+
+
+/**
+ * Check both digits of a BCD field are 0-9 and its value is from min to max
+ */
+STATIC bool
+BCDInRange( uint32_t bcd, uint32_t min, uint32_t max )
+{
+    return ((bcd & 0x0F) <= 9) && ((bcd >> 4) <= 9) && (BCDToBinary( bcd ) >= min) && (BCDToBinary( bcd ) <= max);
+}
+
+
+
+/**
+ * Range check the date/time fields. Parity can't catch an even number of bit errors in a field,
+ * and most corrupted fields that get through make an impossible date or time, or a day of the
+ * week that doesn't go with the date. 1st Jan 2000 was a Saturday.
+ */
+STATIC bool
+CheckFrameRange( uint64_t A_bits )
+{
+uint32_t year  = FRAME_FIELD( A_bits, 17, 24 );
+uint32_t month = FRAME_FIELD( A_bits, 25, 29 );
+uint32_t day   = FRAME_FIELD( A_bits, 30, 35 );
+uint32_t last;
+
+    if (!BCDInRange( year, 0, 99 ) || !BCDInRange( month, 1, 12 ) ||
+        !BCDInRange( FRAME_FIELD( A_bits, 39, 44 ), 0, 23 ) || !BCDInRange( FRAME_FIELD( A_bits, 45, 51 ), 0, 59 ))
+        return false;
+
+    year  = BCDToBinary( year );
+    month = BCDToBinary( month );
+    last  = ((month == 12) ? 365 : DaysBeforeMonth[ month ]) - DaysBeforeMonth[ month - 1 ];
+    if ((month == 2) && ((year % 4) == 0))
+        last++;
+
+    if (!BCDInRange( day, 1, last ))
+        return false;
+
+    return ((DaysSince2000( year, month, BCDToBinary( day )) + 6) % 7) == FRAME_FIELD( A_bits, 36, 38 );
+}
+
+
+
+// Each parity bit in the B channel covers a range of A bits
+STATIC const struct {
+    uint8_t from;
+    uint8_t to;
+    uint8_t parity;
+} ParityGroups[] = {
+    { 17, 24, 54 },
+    { 25, 35, 55 },
+    { 36, 38, 56 },
+    { 39, 51, 57 }
+};
+
+
+
+/**
+ * Validate the received bit stream as per the NPL specification, then range check it
+ *
+ * Each parity check covers a range of A bits along with one B bit. Parity is linear
+ * so XOR-ing the B bit into the masked A bits gives the parity of them all together.
+ *
+ * A frame put together by a vote is counted as a voted failure, so a minute that fails
+ * both before and after the vote isn't counted twice.
+ */
+STATIC bool
+ValidateBCD( sReceiver* pRx, bool bVoted )
+{
+uint32_t marker = FRAME_FIELD( pRx->A_bits, 52, 59 );
+
+    // A52 must be 0, A53 through A58 must be 1, A59 must be 0
+    if (marker != FRAME_MARKER) {
+        LOGprintf(LOG_BCD_ERROR, "A52 to A59 are 0x%02x, not 0x7e!\n", marker);
+        STAT_FAIL( bVoted, MarkerFailures );
+        return false;
+    }
+
+    // A17 through A24 along with B54 must have odd parity
+    if (!CheckOddParity( (pRx->A_bits & FRAME_MASK(17, 24)) ^ (pRx->B_bits & FRAME_BIT(54)) )) {
+        LOGprintf(LOG_BCD_ERROR, "A17 to A24 fail parity check with B54!\n");
+        STAT_FAIL( bVoted, ParityFailures );
+        return false;
+    }
+
+    // A25 through A35 along with B55 must have odd parity
+    if (!CheckOddParity( (pRx->A_bits & FRAME_MASK(25, 35)) ^ (pRx->B_bits & FRAME_BIT(55)) ))  {
+        LOGprintf(LOG_BCD_ERROR, "A25 to A35 fail parity check with B55!\n");
+        STAT_FAIL( bVoted, ParityFailures );
+        return false;
+    }
+
+    // A36 through A38 along with B56 must have odd parity
+    if (!CheckOddParity( (pRx->A_bits & FRAME_MASK(36, 38)) ^ (pRx->B_bits & FRAME_BIT(56)) ))  {
+        LOGprintf(LOG_BCD_ERROR, "A36 to A38 fail parity check with B56!\n");
+        STAT_FAIL( bVoted, ParityFailures );
+        return false;
+    }
+
+    // A39 through A51 along with B57 must have odd parity
+    if (!CheckOddParity( (pRx->A_bits & FRAME_MASK(39, 51)) ^ (pRx->B_bits & FRAME_BIT(57)) )) {
+        LOGprintf(LOG_BCD_ERROR, "A39 to A51 fail parity check with B57!\n");
+        STAT_FAIL( bVoted, ParityFailures );
+        return false;
+    }
+
+    if (!CheckFrameRange( pRx->A_bits )) {
+        LOGprintf(LOG_BCD_ERROR, "Date/time out of range!\n");
+        STAT_FAIL( bVoted, RangeFailures );
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/**
+ * Round a signed number of ticks to the nearest whole second
+ */
+STATIC int32_t
+TicksToSeconds( int32_t ticks )
+{
+int32_t half = (int32_t)(ClockTicksPerSecond / 2);
+
+    return (ticks >= 0) ? ((ticks + half) / (int32_t) ClockTicksPerSecond)
+                        : -((half - ticks) / (int32_t) ClockTicksPerSecond);
+}
+
+
+
+#if (MSF_MEASURE_DRIFT == 1)
+
+/**
+ * Start a new drift measurement block at the current second marker
+ */
+STATIC void
+DriftRestart( sReceiver* pRx )
+{
+    pRx->DriftSumX = pRx->DriftSumY = pRx->DriftSumXX = pRx->DriftSumXY = 0;
+    pRx->nDriftMarkers = 0;
+    pRx->DriftX = pRx->DriftY = 0;
+}
+
+
+
+/**
+ * Add a second marker, 'seconds' after the last one and 'error' ticks from where a perfect
+ * oscillator would put it, to the drift measurement. At the end of the block fit a line
+ * through the markers and fold the slope into the estimate.
+ */
+STATIC void
+DriftAddMarker( sReceiver* pRx, int32_t seconds, int32_t error )
+{
+int64_t num, den;
+int32_t ppb, y;
+
+    // Accumulate the phase in ticks so rounding to us doesn't build up
+    pRx->DriftX += seconds;
+    pRx->DriftY += error;
+    y = (int32_t)(((int64_t) pRx->DriftY * 1000) / (int32_t) MS_TO_TICKS(1));
+
+    pRx->DriftSumX  += pRx->DriftX;
+    pRx->DriftSumY  += y;
+    pRx->DriftSumXX += (int64_t) pRx->DriftX * pRx->DriftX;
+    pRx->DriftSumXY += (int64_t) pRx->DriftX * y;
+    pRx->nDriftMarkers++;
+
+    if (pRx->DriftX < DRIFT_BLOCK_SECONDS)
+        return;
+
+    if (pRx->nDriftMarkers >= DRIFT_MIN_MARKERS)
+    {
+        num = (pRx->nDriftMarkers * pRx->DriftSumXY) - (pRx->DriftSumX * pRx->DriftSumY);
+        den = (pRx->nDriftMarkers * pRx->DriftSumXX) - (pRx->DriftSumX * pRx->DriftSumX);
+        ppb = (int32_t)((num * 1000) / den);
+
+        if (pRx->bDriftValid)
+            pRx->DriftPpb += (ppb - pRx->DriftPpb) >> DRIFT_FILTER_SHIFT;
+        else
+            pRx->DriftPpb = ppb;
+
+        pRx->DriftTicksQ16 = (int32_t)(((int64_t) pRx->DriftPpb * ClockTicksPerSecond * 65536) / 1000000000);
+        pRx->bDriftValid = true;
+
+        LOGprintf(LOG_INFO, "Oscillator drift %d ppb\n", pRx->DriftPpb);
+    }
+
+    DriftRestart( pRx );
+}
+
+#else
+
+#define     DriftRestart( pRx )
+
+#endif  // MSF_MEASURE_DRIFT
+
+
+
+/**
+ * If the clock has reached a summer time change announced by B53, move ClockSeconds by an hour
+ * so the Unix time carries straight on. Called whenever ClockSeconds is advanced.
+ */
+STATIC void
+ClockCheckDst( sReceiver* pRx )
+{
+    if ((pRx->ClockDstChange == 0) || ((pRx->ClockSeconds + pRx->ClockUnixOffset) < pRx->ClockDstChange))
+        return;
+
+    if (pRx->ClockUnixOffset == UNIX_TIME_2000)
+    {
+        pRx->ClockUnixOffset = UNIX_TIME_2000 - BST_OFFSET;
+        pRx->ClockSeconds   += BST_OFFSET;
+    }
+    else
+    {
+        pRx->ClockUnixOffset = UNIX_TIME_2000;
+        pRx->ClockSeconds   -= BST_OFFSET;
+    }
+
+    pRx->ClockDstChange = 0;
+
+    LOGprintf(LOG_INFO, "Clock changed to %s\n", (pRx->ClockUnixOffset == UNIX_TIME_2000) ? "GMT" : "BST");
+}
+
+
+
+/**
+ * Set the clock from the date/time just decoded, civil being its seconds since 2000. T_Minute
+ * is the tick count at the start of the minute marker, which is second 0 of the decoded minute.
+ *
+ * If the clock is already locked to the second markers only the seconds count is set, so
+ * the drift measurement carries on undisturbed.
+ */
+STATIC void
+ClockSetMinute( sReceiver* pRx, uint32_t T_Minute, uint32_t civil )
+{
+int32_t  offset = (int32_t)(pRx->T_ClockSecond - T_Minute);
+int32_t  seconds = TicksToSeconds( offset );
+int32_t  error = offset - (seconds * (int32_t) ClockTicksPerSecond);
+
+    pRx->ClockUnixOffset = UNIX_TIME_2000 - ((pRx->LocalDateTime.DST) ? BST_OFFSET : 0);
+
+    // The warning is on for the hour before the change, so only look for it in the hour before 01:00 UTC
+    pRx->ClockDstChange = 0;
+    if ((pRx->LocalDateTime.DSTWarning) && (((pRx->LocalDateTime.UnixTime / 3600) % 24) == (BST_CHANGE_HOUR - 1)))
+        pRx->ClockDstChange = (pRx->LocalDateTime.UnixTime - (pRx->LocalDateTime.UnixTime % 3600)) + 3600;
+
+    if ((pRx->bClockValid) && (pRx->nClockHoldover == 0) &&
+        (error <= (int32_t) MS_TO_TICKS(CLOCK_MAX_CORRECTION)) && (error >= -(int32_t) MS_TO_TICKS(CLOCK_MAX_CORRECTION)))
+    {
+        pRx->ClockSeconds = civil + seconds;
+        ClockCheckDst( pRx );
+        return;
+    }
+
+    pRx->ClockSeconds   = civil;
+    pRx->T_ClockSecond  = T_Minute;
+    pRx->nClockHoldover = 0;
+    pRx->bClockValid    = true;
+    DriftRestart( pRx );
+}
+
+
+
+/**
+ * The decoder engines call this at every second marker they receive. It's moved from where
+ * the clock expects it by the local oscillator error, so take it as the new start of the second.
+ */
+STATIC void
+SecondMarker( sReceiver* pRx, uint32_t event_time )
+{
+int32_t elapsed = (int32_t)(event_time - pRx->T_ClockSecond);
+int32_t seconds, error;
+
+#if (MSF_VOTE_FRAMES > 0)
+    VoteSecondMarker( pRx, event_time );
+#endif
+
+    if ((!pRx->bClockValid) || (elapsed < 0))
+        return;
+
+    seconds = TicksToSeconds( elapsed );
+    error   = elapsed - (seconds * (int32_t) ClockTicksPerSecond);
+
+    if ((error > (int32_t) MS_TO_TICKS(CLOCK_MAX_CORRECTION)) || (error < -(int32_t) MS_TO_TICKS(CLOCK_MAX_CORRECTION)))
+    {
+        LOGprintf(LOG_SYNC_MSG, "Second marker %d ms off\n", (int32_t) TICKS_TO_MS(error));
+        STAT_COUNT( MSF_STAT_SECOND_MARKER_OFF );
+        return;
+    }
+
+#if (MSF_MEASURE_DRIFT == 1)
+    // After holdover T_ClockSecond isn't a received second marker, so the drift can't be measured from it
+    if (pRx->nClockHoldover == 0)
+        DriftAddMarker( pRx, seconds, error );
+    else
+        DriftRestart( pRx );
+#endif
+
+    pRx->ClockSeconds   += seconds;
+    pRx->T_ClockSecond   = event_time;
+    pRx->nClockHoldover  = 0;
+
+    ClockCheckDst( pRx );
+}
+
+
+
+/**
+ * Without second markers, step the clock forward a whole number of seconds so T_ClockSecond
+ * doesn't fall too far behind the tick count to be compared with it. It's left up to a
+ * second behind so a late second marker can still be recognised. With MSF_MEASURE_DRIFT
+ * each second is corrected for the measured oscillator drift.
+ */
+STATIC void
+ClockHoldover( sReceiver* pRx, uint32_t now )
+{
+uint32_t seconds;
+#if (MSF_MEASURE_DRIFT == 1)
+int64_t  drift;
+#endif
+
+    if (!pRx->bClockValid)
+        return;
+
+    seconds = (now - pRx->T_ClockSecond) / ClockTicksPerSecond;
+    if (seconds < 2)
+        return;
+
+    seconds--;
+
+#if (MSF_MEASURE_DRIFT == 1)
+    drift = ((int64_t) pRx->DriftTicksQ16 * seconds) + pRx->DriftRemainderQ16;
+
+    pRx->T_ClockSecond     += (seconds * ClockTicksPerSecond) + (int32_t)(drift >> 16);
+    pRx->DriftRemainderQ16  = (uint32_t)(drift & 0xFFFF);
+#else
+    pRx->T_ClockSecond     += seconds * ClockTicksPerSecond;
+#endif
+    pRx->ClockSeconds      += seconds;
+    pRx->nClockHoldover    += seconds;
+
+    ClockCheckDst( pRx );
+}
+
+
+
+#if (MSF_ADAPTIVE_MARGINS == 1)
+
+/**
+ * Correct an interval in ms for the receiver's extra delay on CARRIER_ON edges
+ */
+STATIC uint32_t
+AdaptWidth( sReceiver* pRx, uint32_t width, unsigned interval )
+{
+int32_t bias = (pRx->AdaptBiasQ8 + 128) >> 8;
+
+    if (interval == INTERVAL_ON_TO_OFF)
+        bias = -bias;
+    else if (interval == INTERVAL_OFF_TO_OFF)
+        return width;
+
+    if ((bias > 0) && (width < (uint32_t) bias))
+        return 0;
+
+    return width - bias;
+}
+
+
+
+/**
+ * Add the error of a corrected interval to the frame being received. Once the spread has been
+ * learned the error must be within ADAPT_SPREADS of them.
+ *
+ * Returns true if it's within the learned band.
+ */
+STATIC bool
+AdaptInterval( sReceiver* pRx, unsigned interval, int32_t error )
+{
+uint32_t level = (interval == INTERVAL_OFF_TO_ON) ? CARRIER_ON : CARRIER_OFF;
+uint32_t distance = (uint32_t)((error < 0) ? -error : error);
+
+    // Only OFF to ON intervals measure the bias, an ON to OFF is just the same the other way round
+    if (interval == INTERVAL_OFF_TO_ON)
+        pRx->AdaptSum[ level ] += error;
+
+    pRx->AdaptAbsSum[ level ] += distance;
+    pRx->nAdaptIntervals[ level ]++;
+
+    return (pRx->nAdaptFrames < ADAPT_MIN_FRAMES) || (distance <= pRx->AdaptMargin[ level ]);
+}
+
+
+
+/**
+ * The frame being received is complete. If it's good, move the calibration towards what
+ * its intervals measured. Either way start afresh for the next frame.
+ */
+STATIC void
+AdaptFrame( sReceiver* pRx, bool bGood )
+{
+uint32_t level, margin;
+int32_t  spread;
+
+    // A big enough bias could stop every frame validating, so until the first good one the
+    // bias is learned from any frame with enough widths in margin
+    if ((pRx->nAdaptIntervals[ CARRIER_ON ]) &&
+        ((bGood) || ((pRx->nAdaptFrames == 0) && (pRx->nAdaptIntervals[ CARRIER_ON ] >= ADAPT_FIRST_INTERVALS))))
+    {
+        pRx->AdaptBiasQ8 += ((pRx->AdaptSum[ CARRIER_ON ] * 256) / (int32_t) pRx->nAdaptIntervals[ CARRIER_ON ]) >> ADAPT_FILTER_SHIFT;
+        if (pRx->AdaptBiasQ8 > (PULSE_MARGIN << 8))
+            pRx->AdaptBiasQ8 = PULSE_MARGIN << 8;
+        else if (pRx->AdaptBiasQ8 < -(PULSE_MARGIN << 8))
+            pRx->AdaptBiasQ8 = -(PULSE_MARGIN << 8);
+    }
+
+    if ((bGood) && (pRx->nAdaptIntervals[ CARRIER_ON ]) && (pRx->nAdaptIntervals[ CARRIER_OFF ]))
+    {
+        for (level = CARRIER_ON ; level <= CARRIER_OFF ; level++)
+        {
+            spread = (int32_t)((pRx->AdaptAbsSum[ level ] * 256) / pRx->nAdaptIntervals[ level ]);
+
+            if (pRx->nAdaptFrames == 0)
+                pRx->AdaptSpreadQ8[ level ] = spread;
+            else
+                pRx->AdaptSpreadQ8[ level ] += (spread - pRx->AdaptSpreadQ8[ level ]) >> ADAPT_FILTER_SHIFT;
+
+            margin = (uint32_t)((pRx->AdaptSpreadQ8[ level ] * ADAPT_SPREADS) + 255) >> 8;
+            if (margin > PULSE_MARGIN)
+                margin = PULSE_MARGIN;
+            pRx->AdaptMargin[ level ] = (margin > ADAPT_MIN_MARGIN) ? margin : ADAPT_MIN_MARGIN;
+        }
+
+        if (pRx->nAdaptFrames < ADAPT_MIN_FRAMES)
+            pRx->nAdaptFrames++;
+
+        LOGprintf(LOG_INFO, "ON edge bias %d ms, margins %u/%u ms\n", (pRx->AdaptBiasQ8 + 128) >> 8,
+                  pRx->AdaptMargin[ CARRIER_ON ], pRx->AdaptMargin[ CARRIER_OFF ]);
+    }
+
+    for (level = CARRIER_ON ; level <= CARRIER_OFF ; level++)
+    {
+        pRx->AdaptSum[ level ]        = 0;
+        pRx->AdaptAbsSum[ level ]     = 0;
+        pRx->nAdaptIntervals[ level ] = 0;
+    }
+}
+
+#endif  // MSF_ADAPTIVE_MARGINS
+
+
+
+#if (MSF_ENABLE_QUALITY == 1) || ((MSF_ADAPTIVE_MARGINS == 1) && (MSF_DECODER_ENGINE == MSF_ENGINE_SOFT))
+
+/**
+ * Measure how far an edge offset ms into the cell is from the nearest place an edge can be,
+ * 100, 200, 300 or 500ms after the second marker. Both engines measure their edges this way.
+ *
+ * Returns false if it's nowhere near one, out of margin. The error is left in *pError.
+ */
+STATIC bool
+CellEdgeError( int32_t offset, int32_t* pError )
+{
+int32_t nominal = ((offset + 50) / 100) * 100;
+
+    *pError = offset - nominal;
+
+    return (nominal >= 100) && (nominal <= 500) && (nominal != 400) &&
+           (*pError <= PULSE_MARGIN) && (*pError >= -PULSE_MARGIN);
+}
+
+#endif
+
+
+
+#if (MSF_ENABLE_QUALITY == 1)
+
+/**
+ * Move a signal quality average 1/16 of the way to a new sample
+ */
+STATIC int32_t
+QualityAverage( int32_t average, int32_t sample )
+{
+    return average + ((sample - average) >> QUALITY_FILTER_SHIFT);
+}
+
+
+
+/**
+ * Record how far an edge was from its nominal time, in ms. An edge out of margin has no
+ * nominal time and only counts in the last histogram bin.
+ */
+STATIC void
+QualityEdge( sReceiver* pRx, int32_t error, bool bInMargin )
+{
+uint32_t bin = MSF_QUALITY_ERROR_BINS - 1;
+
+    if (bInMargin)
+    {
+        if (error < 0)
+            error = -error;
+
+        bin = (uint32_t) error / QUALITY_BIN_MS;
+        if (bin > MSF_QUALITY_ERROR_BINS - 2)
+            bin = MSF_QUALITY_ERROR_BINS - 2;
+
+        pRx->QualityErrorQ8 = QualityAverage( pRx->QualityErrorQ8, error << 8 );
+    }
+
+    pRx->QualityHistogram[ bin ]++;
+    pRx->QualityInMarginQ8 = QualityAverage( pRx->QualityInMarginQ8, (bInMargin) ? (100 << 8) : 0 );
+}
+
+
+
+/**
+ * Count the parity groups a complete frame fails before any correction. A group with an
+ * erased cell fails too. Each group fails for about one bit error in it, so over all four
+ * it's roughly the bit errors in QUALITY_PARITY_BITS bits.
+ */
+STATIC void
+QualityFrame( sReceiver* pRx, uint64_t erased )
+{
+unsigned group;
+int32_t  failed = 0;
+uint64_t mask;
+
+    for (group = 0 ; group < sizeof(ParityGroups) / sizeof(ParityGroups[0]) ; group++)
+    {
+        mask = FRAME_MASK( ParityGroups[group].from, ParityGroups[group].to );
+
+        if ((erased & (mask | FRAME_BIT(ParityGroups[group].parity))) ||
+            !CheckOddParity( (pRx->A_bits & mask) ^ (pRx->B_bits & FRAME_BIT(ParityGroups[group].parity)) ))
+            failed++;
+    }
+
+    pRx->QualityParityQ8 = QualityAverage( pRx->QualityParityQ8, failed << 8 );
+}
+
+
+
+/**
+ * Once a second, move the lock quality towards the mean of the edges in margin, the edge
+ * timing error as a part of PULSE_MARGIN and the parity groups passed. It falls to 0
+ * without SYNC.
+ */
+STATIC void
+QualitySecond( sReceiver* pRx, uint32_t now )
+{
+uint32_t seconds = (now - pRx->T_QualitySecond) / ClockTicksPerSecond;
+int32_t  timing, parity, target = 0;
+
+    if (seconds == 0)
+        return;
+
+    pRx->T_QualitySecond += seconds * ClockTicksPerSecond;
+
+    if (pRx->bSyncedFlag)
+    {
+        timing = (100 << 8) - ((pRx->QualityErrorQ8 * 100) / PULSE_MARGIN);
+        parity = (100 << 8) - (pRx->QualityParityQ8 * 25);
+        target = (pRx->QualityInMarginQ8 + ((timing > 0) ? timing : 0) + ((parity > 0) ? parity : 0)) / 3;
+    }
+
+    // A few time constants is enough to forget the old value after a gap
+    if (seconds > (4 << QUALITY_FILTER_SHIFT))
+        seconds = 4 << QUALITY_FILTER_SHIFT;
+
+    for ( ; seconds ; seconds--)
+        pRx->QualityLockQ8 = QualityAverage( pRx->QualityLockQ8, target );
+}
+
+#endif  // MSF_ENABLE_QUALITY
+
+
+
+/**
+ * Update the snapshot read by MSF_ReadDateTime(), in the buffer readers aren't using
+ */
+STATIC void
+PublishDateTime( const sMSFDateTime* pDateTime )
+{
+    uint32_t generation = DateTimeGeneration;
+
+    DateTimeGeneration = generation + 1;
+    DateTimeSnapshot[ ((generation >> 1) + 1) & 1 ] = *pDateTime;
+    DateTimeGeneration = generation + 2;
+}
+
+
+
+/**
+ * Check if two decoded date/times are the same minute
+ */
+STATIC bool
+SameMinute( const sMSFDateTime* pA, const sMSFDateTime* pB )
+{
+    return (pA->Year == pB->Year) && (pA->Month == pB->Month) && (pA->Day == pB->Day) &&
+           (pA->Hour == pB->Hour) && (pA->Minute == pB->Minute) && (pA->DST == pB->DST);
+}
+
+
+
+/**
+ * Check a frame that's passed validation against the minute the free running clock predicts,
+ * or the lead receiver's if this one's hasn't been set, then against the last frame that
+ * wasn't predicted. A frame that matches neither is kept as the candidate. *pbContradicts is
+ * set if there was a prediction and the frame didn't match it or the candidate.
+ *
+ * The frames are compared in Unix time, so a frame with a corrupt B58 DST bit doesn't match
+ * the same civil time. The clock also predicts the DST bit, from its offset and any change
+ * the summer time warning scheduled.
+ */
+STATIC eMSFFrameCheck
+CheckFramePrediction( sReceiver* pRx, uint32_t T_Minute, const sMSFDateTime* pFrame, bool* pbContradicts )
+{
+const sReceiver* pClockRx = (pRx->bClockValid) ? pRx : pLeadRx;
+eMSFFrameCheck   check = MSF_FRAME_UNCONFIRMED;
+uint32_t         predicted;
+uint8_t          dst;
+
+    if (pClockRx->bClockValid)
+    {
+        predicted = pClockRx->ClockSeconds + pClockRx->ClockUnixOffset -
+                    TicksToSeconds( (int32_t)(pClockRx->T_ClockSecond - T_Minute) );
+
+        dst = (pClockRx->ClockUnixOffset != UNIX_TIME_2000) ? 1 : 0;
+        if ((pClockRx->ClockDstChange) && (pFrame->UnixTime >= pClockRx->ClockDstChange))
+            dst ^= 1;
+
+        // To the nearest minute, so a clock that's drifted in holdover still counts
+        if ((((predicted + 30) / 60) == (pFrame->UnixTime / 60)) && (pFrame->DST == dst))
+            check = MSF_FRAME_PREDICTED;
+    }
+
+    if ((check == MSF_FRAME_UNCONFIRMED) && (pRx->bCandidate) &&
+        ((pRx->CandidateSeconds + ((pRx->nMinuteMarkers - pRx->CandidateMinute) * 60)) == pFrame->UnixTime))
+        check = MSF_FRAME_CONFIRMED;
+
+    *pbContradicts        = (check == MSF_FRAME_UNCONFIRMED) && (pClockRx->bClockValid);
+    pRx->bCandidate       = (check == MSF_FRAME_UNCONFIRMED);
+    pRx->CandidateSeconds = pFrame->UnixTime;
+    pRx->CandidateMinute  = pRx->nMinuteMarkers;
+
+    return check;
+}
+
+
+
+/**
+ * Set the clock from a frame that's been accepted and pass it on to the client
+ */
+STATIC void
+AcceptFrame( sReceiver* pRx, uint32_t T_Minute, uint32_t civil )
+{
+    pRx->LocalDateTime.bHasValidTime    = true;
+    pRx->LocalDateTime.bDateTimeUpdated = true;
+
+    ClockSetMinute( pRx, T_Minute, civil );
+
+    // The first receiver to decode a frame sets the time for everyone
+    if (!pLeadRx->bClockValid)
+        pLeadRx = pRx;
+
+    // Unless another receiver has already reported this minute, pass it on
+    if ((pFleetRx == NULL) || (pFleetRx == pRx) || !SameMinute( &pRx->LocalDateTime, &FleetDateTime ))
+    {
+        FleetDateTime = pRx->LocalDateTime;
+        pFleetRx      = pRx;
+
+        PublishDateTime( &pRx->LocalDateTime );
+
+        // Copy to the client's data struct if it's valid
+        if ((pClientDateTime) && (pRx->LocalDateTime.bHasValidTime))
+        {
+            *pClientDateTime = pRx->LocalDateTime;
+        }
+
+        // Notify the client
+        ClientEventNotify( pRx, MSF_EVENT_DATETIME_UPDATED );
+    }
+}
+
+
+
+/**
+ * Once we have received a full frame of 59 bits try to decode it.
+ * If it's valid & the client supplied a buffer, copy in the date/time.
+ * bVoted is true for a frame VoteFrames() put together.
+ *
+ */
+STATIC bool
+DecodeFrame( sReceiver* pRx, uint32_t T_Minute, bool bVoted )
+{
+#if (MSF_ENABLE_STATS == 1)
+    uint32_t stat_start = CYCLE_COUNT();
+#endif
+
+    bool bFrameValid = ValidateBCD( pRx, bVoted );
+    sMSFDateTime frame;
+    uint32_t civil;
+    bool bContradicts;
+
+#if (MSF_ADAPTIVE_MARGINS == 1)
+    // Only the first decode of a frame learns, a retry with the voted frame finds nothing to learn from
+    AdaptFrame( pRx, bFrameValid );
+#endif
+
+    if (bFrameValid == true)
+    {
+        STAT_INC( FramesDecoded );
+
+        // Dump A and B bit buffers to the debug UART
+        LOGprintf(LOG_BIT_DUMP, "", (uint32_t)(pRx->A_bits >> 32), (uint32_t) pRx->A_bits,
+                                    (uint32_t)(pRx->B_bits >> 32), (uint32_t) pRx->B_bits);
+
+        // Only the frames accepted are kept, the hard engine fills in lost cells from the last one
+        frame = pRx->LocalDateTime;
+
+        frame.Year    = BCDToBinary( FRAME_FIELD( pRx->A_bits, 17, 24 ));    // 0-99
+        frame.Month   = BCDToBinary( FRAME_FIELD( pRx->A_bits, 25, 29 ));    // 1-12
+        frame.Day     = BCDToBinary( FRAME_FIELD( pRx->A_bits, 30, 35 ));    // 1-31
+        frame.DOW     = BCDToBinary( FRAME_FIELD( pRx->A_bits, 36, 38 ));    // 0-6
+        frame.Hour    = BCDToBinary( FRAME_FIELD( pRx->A_bits, 39, 44 ));    // 0-23
+        frame.Minute  = BCDToBinary( FRAME_FIELD( pRx->A_bits, 45, 51 ));    // 0-59
+        frame.DST     = FRAME_FIELD( pRx->B_bits, 58, 58 );                  // 0 or 1
+
+        frame.DSTWarning = FRAME_FIELD( pRx->B_bits, 53, 53 );
+        frame.DUT1Valid  = DecodeDUT1( pRx->B_bits, &frame.DUT1 );
+        frame.A_bits     = pRx->A_bits;
+        frame.B_bits     = pRx->B_bits;
+
+        if (!frame.DUT1Valid) {
+            LOGprintf(LOG_BCD_ERROR, "B1 to B16 aren't a valid DUT1!\n");
+        }
+
+        civil = (DaysSince2000( frame.Year, frame.Month, frame.Day ) * 86400) +
+                (frame.Hour * 3600) + (frame.Minute * 60);
+
+        frame.UnixTime   = civil + UNIX_TIME_2000 - ((frame.DST) ? BST_OFFSET : 0);
+        frame.FrameCheck = CheckFramePrediction( pRx, T_Minute, &frame, &bContradicts );
+
+#if (MSF_FRAME_PREDICTION == 1)
+        // Hold back a frame the clock predicted otherwise until the next one confirms it. With
+        // nothing to predict it, e.g. after reset, it's published unconfirmed for the client to judge.
+        if (bContradicts)
+        {
+            LOGprintf(LOG_INFO, "Frame %02u:%02u not predicted, waiting for the next\n",
+                      frame.Hour, frame.Minute);
+            STAT_INC( FramesHeld );
+        }
+        else
+#else
+        (void) bContradicts;
+#endif
+        {
+            pRx->LocalDateTime = frame;
+            AcceptFrame( pRx, T_Minute, civil );
+        }
+    }
+
+
+#if (MSF_ENABLE_STATS == 1)
+    StatAddCycles( &pRx->Stats.DecodeFrame, stat_start );
+#endif
+
+    return bFrameValid;
+}
+
+
+
+#if (MSF_VOTE_FRAMES > 0)
+
+/**
+ * Forget the frame history and start counting the seconds again from a second marker at
+ * event_time.
+ */
+STATIC void
+VoteRestart( sReceiver* pRx, uint32_t event_time )
+{
+    if (pRx->nVoteFrames)
+    {
+        LOGprintf(LOG_INFO, "Lost count of the seconds, frame history cleared\n");
+    }
+
+    pRx->nVoteFrames   = 0;
+    pRx->bVoteCounting = true;
+    pRx->VoteSeconds   = 0;
+    pRx->T_VoteSecond  = event_time;
+}
+
+
+
+/**
+ * Work out the second count at tick count t, which should be a second marker.
+ *
+ * Returns false if it isn't in step with the second markers counted so far.
+ */
+STATIC bool
+VoteSecondAt( const sReceiver* pRx, uint32_t t, uint32_t* pSecond )
+{
+int32_t offset = (int32_t)(t - pRx->T_VoteSecond);
+int32_t seconds = TicksToSeconds( offset );
+int32_t error = offset - (seconds * (int32_t) ClockTicksPerSecond);
+
+    *pSecond = pRx->VoteSeconds + seconds;
+
+    return (pRx->bVoteCounting) &&
+           (error <= (int32_t) MS_TO_TICKS(CLOCK_MAX_CORRECTION)) && (error >= -(int32_t) MS_TO_TICKS(CLOCK_MAX_CORRECTION));
+}
+
+
+
+/**
+ * Count the seconds from every second marker, see SecondMarker(). One out of step while
+ * there's any history is taken as noise, the minute markers decide if the count was wrong.
+ */
+STATIC void
+VoteSecondMarker( sReceiver* pRx, uint32_t event_time )
+{
+uint32_t second;
+
+    if (VoteSecondAt( pRx, event_time, &second ))
+    {
+        pRx->VoteSeconds  = second;
+        pRx->T_VoteSecond = event_time;
+    }
+    else if (pRx->nVoteFrames == 0)
+    {
+        VoteRestart( pRx, event_time );
+    }
+}
+
+
+
+/**
+ * Keep counting the seconds without second markers, as ClockHoldover() does for the clock.
+ * A frame is only voted on for MSF_VOTE_FRAMES minutes, which is too short for the local
+ * oscillator to drift out of step.
+ */
+STATIC void
+VoteHoldover( sReceiver* pRx, uint32_t now )
+{
+uint32_t seconds;
+
+    if (!pRx->bVoteCounting)
+        return;
+
+    seconds = (now - pRx->T_VoteSecond) / ClockTicksPerSecond;
+    if (seconds < 2)
+        return;
+
+    seconds--;
+
+    pRx->T_VoteSecond += seconds * ClockTicksPerSecond;
+    pRx->VoteSeconds  += seconds;
+}
+
+
+
+/**
+ * Add the frame just received to the history, erased marking the cells it lost
+ */
+STATIC void
+VoteAddFrame( sReceiver* pRx, uint64_t erased, uint32_t second )
+{
+sVoteFrame* pFrame = &pRx->VoteHistory[ pRx->nVoteFrames % MSF_VOTE_FRAMES ];
+
+    pFrame->A_bits = pRx->A_bits;
+    pFrame->B_bits = pRx->B_bits;
+    pFrame->Erased = erased;
+    pFrame->second = second;
+
+    if (++pRx->nVoteFrames == 2 * MSF_VOTE_FRAMES)
+        pRx->nVoteFrames = MSF_VOTE_FRAMES;
+}
+
+
+
+/**
+ * Convert a binary value 0-99 to BCD
+ */
+STATIC uint32_t
+BinaryToBCD( uint32_t value )
+{
+    return ((value / 10) << 4) | (value % 10);
+}
+
+
+
+/**
+ * Advance a frame received some minutes ago to the current minute. The hour & minute fields
+ * are re-encoded and the B57 parity bit adjusted so it only matches if it matched before.
+ * If any of the hour or minute cells were lost the whole field is erased.
+ *
+ * Returns false if the advance crosses midnight, as the date would change too.
+ */
+STATIC bool
+VoteAdvanceFrame( uint64_t* pA, uint64_t* pB, uint64_t* pErased, uint32_t minutes )
+{
+uint32_t old_hm = FRAME_FIELD( *pA, 39, 51 );
+uint32_t new_hm;
+uint32_t minute, hour;
+
+    if (minutes == 0)
+        return true;
+
+    if (*pErased & FRAME_MASK(39, 51))
+    {
+        *pErased |= FRAME_MASK(39, 51) | FRAME_BIT(57);
+        return true;
+    }
+
+    minute = BCDToBinary( FRAME_FIELD( *pA, 45, 51 )) + minutes;
+    hour   = BCDToBinary( FRAME_FIELD( *pA, 39, 44 )) + (minute / 60);
+    minute %= 60;
+
+    if (hour >= 24)
+        return false;
+
+    new_hm = (BinaryToBCD( hour ) << 7) | BinaryToBCD( minute );
+
+    *pA = (*pA & ~FRAME_MASK(39, 51)) | ((uint64_t) new_hm << (63 - 51));
+
+    if (CheckOddParity( old_hm ) != CheckOddParity( new_hm ))
+        *pB ^= FRAME_BIT(57);
+
+    return true;
+}
+
+
+
+/**
+ * Vote on one bit of the frame in *pVoted, over the n frames that didn't lose it. A tie leaves
+ * the current frame's bit. If every frame lost it, it stays erased in *pVotedErased.
+ *
+ * Returns how far the votes agreed, 0-100.
+ */
+STATIC unsigned
+VoteBit( const uint64_t* pFrames, const uint64_t* pErased, unsigned n, uint64_t bit, uint64_t* pVoted, uint64_t* pVotedErased )
+{
+unsigned i, ones = 0, zeros = 0;
+
+    for (i = 0 ; i < n ; i++)
+    {
+        if (pErased[ i ] & bit)
+            continue;
+        if (pFrames[ i ] & bit)
+            ones++;
+        else
+            zeros++;
+    }
+
+    if (ones + zeros == 0)
+        return SOFT_MAX_CONFIDENCE;
+
+    if (ones == zeros)
+        return 0;
+
+    *pVotedErased &= ~bit;
+
+    if (ones > zeros)
+        *pVoted |= bit;
+    else
+        *pVoted &= ~bit;
+
+    return (SOFT_MAX_CONFIDENCE * ((ones > zeros) ? ones - zeros : zeros - ones)) / (ones + zeros);
+}
+
+
+
+/**
+ * Take a per-bit vote over the frames in the history received in the last MSF_VOTE_FRAMES
+ * minutes, advanced to the current minute which started at second. Only the frames that
+ * received a cell vote on it. The result is left in A_bits & B_bits, *pErased is updated to
+ * the cells no frame received and FrameConfidence to how well the votes agreed.
+ *
+ * Returns false if there isn't enough history for a vote.
+ */
+STATIC bool
+VoteFrames( sReceiver* pRx, uint32_t second, uint64_t* pErased )
+{
+uint64_t A[ MSF_VOTE_FRAMES ];
+uint64_t B[ MSF_VOTE_FRAMES ];
+uint64_t E[ MSF_VOTE_FRAMES ];
+uint64_t voted_A = pRx->A_bits;
+uint64_t voted_B = pRx->B_bits;
+uint64_t erased_A = *pErased;
+uint64_t erased_B = *pErased;
+unsigned n = 0, i, bitnum, agree, confidence = SOFT_MAX_CONFIDENCE;
+uint32_t age;
+
+    for (i = 0 ; (i < pRx->nVoteFrames) && (i < MSF_VOTE_FRAMES) ; i++)
+    {
+        age = second - pRx->VoteHistory[ i ].second;
+        if ((age % 60) || (age >= (MSF_VOTE_FRAMES * 60)))
+            continue;
+
+        A[ n ] = pRx->VoteHistory[ i ].A_bits;
+        B[ n ] = pRx->VoteHistory[ i ].B_bits;
+        E[ n ] = pRx->VoteHistory[ i ].Erased;
+        if (VoteAdvanceFrame( &A[ n ], &B[ n ], &E[ n ], age / 60 ))
+            n++;
+    }
+
+    if (n < 2)
+        return false;
+
+    for (bitnum = 1 ; bitnum <= 59 ; bitnum++)
+    {
+        agree = VoteBit( A, E, n, FRAME_BIT(bitnum), &voted_A, &erased_A );
+        if (agree < confidence)
+            confidence = agree;
+
+        // As the soft engine's confidence, only the B bits that matter count
+        agree = VoteBit( B, E, n, FRAME_BIT(bitnum), &voted_B, &erased_B );
+        if ((bitnum >= 54) && (agree < confidence))
+            confidence = agree;
+    }
+
+    LOGprintf(LOG_INFO, "Voted over %u frames\n", n);
+
+    pRx->A_bits          = voted_A;
+    pRx->B_bits          = voted_B;
+    pRx->FrameConfidence = confidence;
+    *pErased             = erased_A | erased_B;
+
+    return true;
+}
+
+#endif // MSF_VOTE_FRAMES
+
+
+
+/**
+ * The decoder engines call this at every minute marker, T_Minute is the tick count at the
+ * start of it. erased marks the cells of the frame just received that were lost and couldn't
+ * be recovered, FRAME_ALL_ERASED if there's no frame. If a complete frame has been received
+ * decode it. If that fails, or cells were lost, try again with a vote over the recent frames.
+ *
+ * Returns true if a valid date/time was decoded.
+ */
+STATIC bool
+MinuteMarker( sReceiver* pRx, uint64_t erased, uint32_t T_Minute )
+{
+#if (MSF_VOTE_FRAMES > 0)
+uint32_t second;
+#endif
+
+    pRx->nMinuteMarkers++;
+
+#if (MSF_ADAPTIVE_MARGINS == 1)
+    // DecodeFrame() learns from a complete frame, an incomplete one teaches nothing
+    if (erased)
+        AdaptFrame( pRx, false );
+#endif
+
+#if (MSF_VOTE_FRAMES > 0)
+
+    // A minute marker out of step with the seconds counted means the count was wrong
+    if (!VoteSecondAt( pRx, T_Minute, &second ))
+    {
+        VoteRestart( pRx, T_Minute );
+        second = 0;
+    }
+
+    if (erased == FRAME_ALL_ERASED)
+        return false;
+
+    VoteAddFrame( pRx, erased, second );
+
+    if ((erased == 0) && DecodeFrame( pRx, T_Minute, false ))
+        return true;
+
+    if (!VoteFrames( pRx, second, &erased ))
+        return false;
+
+#if (MSF_DECODER_ENGINE == MSF_ENGINE_HARD)
+    // Fill in the cells no frame received
+    if (!HardRecoverFrame( pRx, erased ))
+        return false;
+#endif
+
+    return DecodeFrame( pRx, T_Minute, true );
+
+#else
+
+    return (erased == 0) ? DecodeFrame( pRx, T_Minute, false ) : false;
+
+#endif
+}
+
+
+
+#if (MSF_DECODER_ENGINE == MSF_ENGINE_HARD)
+
+/**
+ * Classify a pulse width in milliseconds with one of the OffWidthTable, OnWidthTable or
+ * CellOffsetTable lookup tables. Only the widths we may encounter in a valid signal are
+ * recognised, anything else is eWidth_INVALID. 'interval' is the INTERVAL_ type it is,
+ * for the pulse width calibration.
+ *
+ */
+STATIC eWidth
+GetWidth( sReceiver* pRx, const uint8_t* pTable, unsigned interval, uint32_t width )
+{
+    uint32_t index;
+    eWidth   result;
+#if (MSF_ADAPTIVE_MARGINS == 1)
+    int32_t  error;
+#endif
+
+#if (MSF_ADAPTIVE_MARGINS == 1)
+    width = AdaptWidth( pRx, width, interval );
+#else
+    (void) pRx;
+    (void) interval;
+#endif
+
+    index  = width >> WIDTH_TABLE_SHIFT;
+    result = (index < WIDTH_TABLE_SIZE) ? (eWidth) pTable[ index ] : eWidth_INVALID;
+
+#if (MSF_ADAPTIVE_MARGINS == 1)
+    // The width classes are the nominal width in 100s of ms
+    error  = (int32_t) width - ((int32_t) result * 100);
+
+    if ((result != eWidth_INVALID) && !AdaptInterval( pRx, interval, error ))
+        result = eWidth_INVALID;
+#endif
+
+#if (MSF_ENABLE_STATS == 1)
+    // Each table classifies a different pulse, so keep a histogram for each
+    if (pTable == OffWidthTable)
+        STAT_INC( OffWidths[ result ] );
+    else if (pTable == OnWidthTable)
+        STAT_INC( OnWidths[ result ] );
+    else
+        STAT_INC( CellOffsets[ result ] );
+#endif
+
+    return result;
+}
+
+
+
+/**
+ * Forget the bit number, and optionally the 1 Hz phase too.
+ */
+STATIC void
+HardLoseSync( sReceiver* pRx, bool bLosePhase )
+{
+    if (pRx->bSyncedFlag)
+    {
+        LOGprintf(LOG_SYNC_MSG, "SYNC lost\n");
+        STAT_COUNT( MSF_STAT_SYNC_LOST );
+    }
+
+    SetSyncState( pRx, false );
+    pRx->bHalfSync   = false;
+    pRx->bCellError  = false;
+    pRx->nBitNum     = 0;
+
+    if (bLosePhase)
+    {
+        pRx->bPhaseLocked    = false;
+        pRx->CellShiftErased = ~0ULL;
+    }
+}
+
+
+
+/**
+ * Fill in the bits of erased cells where the frame structure allows it. The A52-A59 marker
+ * bits are fixed, B58 and the DUT1 bits B1 to B16 are taken from the last valid frame and
+ * a single erased bit in each parity group is solved for.
+ *
+ * Returns false if the frame can't be recovered.
+ */
+STATIC bool
+HardRecoverFrame( sReceiver* pRx, uint64_t erased )
+{
+unsigned group;
+uint64_t mask, lost;
+
+    // DUT1 only changes a few times a year. Without a last frame, set both signs so it's invalid.
+    if (erased & FRAME_MASK(1, 16))
+    {
+        if (pRx->LocalDateTime.bHasValidTime)
+            pRx->B_bits ^= (pRx->B_bits ^ pRx->LocalDateTime.B_bits) & erased & FRAME_MASK(1, 16);
+        else
+            pRx->B_bits |= FRAME_BIT(1) | FRAME_BIT(9);
+    }
+
+    erased &= FRAME_MASK(17, 59);
+    if (erased == 0)
+        return true;
+
+    pRx->A_bits ^= (pRx->A_bits ^ ((uint64_t) FRAME_MARKER << (63 - 59))) & erased & FRAME_MASK(52, 59);
+
+    // DST only changes twice a year
+    if (erased & FRAME_BIT(58))
+    {
+        if (!pRx->LocalDateTime.bHasValidTime)
+            return false;
+        setBit( &pRx->B_bits, 58, pRx->LocalDateTime.DST );
+    }
+
+    for (group = 0 ; group < sizeof(ParityGroups) / sizeof(ParityGroups[0]) ; group++)
+    {
+        mask = FRAME_MASK( ParityGroups[group].from, ParityGroups[group].to );
+        lost = erased & (mask | FRAME_BIT(ParityGroups[group].parity));
+
+        if (lost == 0)
+            continue;
+
+        if (lost & (lost - 1))
+        {
+            LOGprintf(LOG_BCD_ERROR, "Lost too many cells in A%u to A%u!\n", ParityGroups[group].from, ParityGroups[group].to);
+            return false;
+        }
+
+        // Only one bit is unknown so the parity says what it must be
+        if (!CheckOddParity( (pRx->A_bits & mask) ^ (pRx->B_bits & FRAME_BIT(ParityGroups[group].parity)) ))
+        {
+            if (lost & mask)
+                pRx->A_bits ^= lost;
+            else
+                pRx->B_bits ^= lost;
+        }
+
+        LOGprintf(LOG_BCD_ERROR, "Recovered a lost cell in A%u to A%u\n", ParityGroups[group].from, ParityGroups[group].to);
+    }
+
+    return true;
+}
+
+
+
+/**
+ * The frame is complete. Pick it out of the shift registers, cell 59 is in bit 0, and decode it.
+ * T_Minute is the start of the minute marker cell.
+ */
+STATIC void
+HardEndFrame( sReceiver* pRx, uint32_t T_Minute )
+{
+uint64_t erased = (pRx->CellShiftErased << (63 - 59)) & FRAME_ALL_ERASED;
+
+    pRx->A_bits = pRx->CellShiftA << (63 - 59);
+    pRx->B_bits = pRx->CellShiftB << (63 - 59);
+    pRx->FrameConfidence = SOFT_MAX_CONFIDENCE;
+
+#if (MSF_ENABLE_QUALITY == 1)
+    // Only a frame followed from its start is a fair measure of the bit error rate
+    if (pRx->nBitNum == 60)
+        QualityFrame( pRx, erased );
+#endif
+
+    MinuteMarker( pRx, (HardRecoverFrame( pRx, erased )) ? 0 : erased, T_Minute );
+}
+
+
+
+/**
+ * The current cell, which started at tick count cell_start, is complete. Shift it into the
+ * frame. If the bit number isn't known look for the A52-A59 pattern to find it.
+ */
+STATIC void
+HardEndCell( sReceiver* pRx, bool bErased, uint32_t cell_start )
+{
+    if (pRx->nBitNum == 60)
+    {
+        // We've lost the minute marker but still know where the frame ends
+        if (bErased)
+        {
+            HardEndFrame( pRx, cell_start );
+            pRx->nBitNum = 1;
+            return;
+        }
+
+        LOGprintf(LOG_SYNC_MSG, "Missing minute marker\n");
+        STAT_COUNT( MSF_STAT_MISSING_MINUTE );
+        HardLoseSync( pRx, false );
+    }
+
+    pRx->CellShiftA      = (pRx->CellShiftA << 1) | pRx->bCellA;
+    pRx->CellShiftB      = (pRx->CellShiftB << 1) | pRx->bCellB;
+    pRx->CellShiftErased = (pRx->CellShiftErased << 1) | bErased;
+
+    if (pRx->nBitNum != 0)
+    {
+        pRx->nBitNum++;
+    }
+    else if (((pRx->CellShiftA & 0xFF) == FRAME_MARKER) && ((pRx->CellShiftErased & 0xFF) == 0))
+    {
+        // That was A59, the minute marker is next
+        LOGprintf(LOG_SYNC_MSG, "SYNC on A52 to A59\n");
+        STAT_COUNT( MSF_STAT_SYNC_ON_MARKER_BITS );
+        SetSyncState( pRx, true );
+        pRx->nBitNum = 60;
+    }
+}
+
+
+
+/**
+ * Skip over a corrupt cell. Edges are ignored until a CARRIER_OFF arrives a whole number
+ * of cells after the start of the corrupt one, then each cell in between is erased.
+ */
+STATIC void
+HardSkipCells( sReceiver* pRx, uint32_t event_time )
+{
+uint32_t ms = TICKS_TO_MS(event_time - pRx->T_CellStart);
+uint32_t cells = (ms + (CELL_LENGTH / 2)) / CELL_LENGTH;
+int32_t  error = (int32_t)(ms - (cells * CELL_LENGTH));
+uint32_t cell_start = pRx->T_CellStart;
+
+    if (cells > HARD_MAX_LOST_CELLS)
+    {
+        LOGprintf(LOG_SYNC_MSG, "Second markers lost\n");
+        STAT_COUNT( MSF_STAT_SECOND_MARKERS_LOST );
+        HardLoseSync( pRx, true );
+        pRx->T_CellStart = event_time;
+        return;
+    }
+
+    if ((cells == 0) || (error > PULSE_MARGIN) || (error < -PULSE_MARGIN))
+        return;
+
+    LOGprintf(LOG_EDGE_ERROR, "Lost %u cell(s)\n", cells);
+    STAT_COUNT( MSF_STAT_LOST_CELLS );
+
+    pRx->bCellError = false;
+    pRx->T_CellStart = event_time;
+    while (cells--)
+    {
+        HardEndCell( pRx, true, cell_start );
+        cell_start += MS_TO_TICKS(CELL_LENGTH);
+    }
+
+    SecondMarker( pRx, event_time );
+}
+
+
+
+/*******************************************************************
+* NAME  HandleCarrierEvent
+*
+* DESCRIPTION
+*       Processes changes in the carrier signal from the radio
+*
+* PARAMETERS
+*       uint32_t    event_level     CARRIER_ON or CARRIER_OFF GPIO pin level
+*       uint32_t    event_time      Tick count latched when the edge occurred
+*
+* OUTPUTS
+*       If a valid time is decoded it is copied to the users pUserDateTime
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*
+* 1. Find the 1 Hz phase from a cell ending in 700, 800 or 900ms CARRIER_ON, or the minute SYNC,
+*    500ms CARRIER_OFF then 500 ms CARRIER_ON then CARRIER_OFF
+* 2. Determine if the event_level & timing is valid for the current state
+* 3. Extract the A and B bits from each second/cell and shift them into the frame.
+* 4. Find the bit number from the minute SYNC, or the A52-A59 01111110 pattern.
+* 5. At the end of the frame, validate the received A & B bit stream.
+* 6. If the frame is valid, decode & save the date/time information.
+* 7. If the client registered a buffer, copy the date/time into it & set the update flag.
+* 8. If the client registered an event callback, notify the date/time has updated.
+*
+* If an unexpected or impossible state or timing is detected only that cell is lost. The
+* rest of it is skipped until the next second marker and it's filled in from the parity
+* bits if possible. If no second marker turns up for HARD_MAX_LOST_CELLS the 1 Hz phase
+* has been lost and the decoder reSYNCs.
+*
+* This is called from MSF_Process() in thread context, not from the radio ISR.
+*
+*/
+STATIC void
+HandleCarrierEvent( sReceiver* pRx, uint32_t event_level, uint32_t event_time)
+{
+    eWidth eCellOffset = eWidth_INVALID;
+    uint32_t msNextEdge;
+    bool bError = false;
+    bool bCellEnd = false;
+#if (MSF_ENABLE_QUALITY == 1)
+    bool bMeasure = pRx->bPhaseLocked && ((event_level == CARRIER_ON) || (event_level == CARRIER_OFF));
+    uint32_t msOffset = TICKS_TO_MS(event_time - pRx->T_CellStart);
+    int32_t error;
+    bool bInMargin;
+#endif
+
+    switch (event_level)
+    {
+        case CARRIER_OFF:
+        {
+            // Update state tracking variables
+            pRx->T_LastOffStart = event_time;
+            pRx->eLastOnWidth   = GetWidth(pRx, OnWidthTable, INTERVAL_ON_TO_OFF, TICKS_TO_MS(event_time - pRx->T_LastOnStart));
 
             // Log carrier is now OFF and the last ON duration
-            LOGprintf(LOG_CARRIER_EVENT, "OFF %u\n", event_time - T_LastOnStart);
+            LOGprintf(LOG_CARRIER_EVENT, "OFF %u\n", TICKS_TO_MS(event_time - pRx->T_LastOnStart));
+
+            // Skipping a corrupt cell, is this the next second marker?
+            if (pRx->bCellError)
+            {
+                HardSkipCells( pRx, event_time );
+                break;
+            }
 
-            // If we're not SYNCd, every CARRIER_OFF is potentially the start of a new second/cell
-            if (bSyncedFlag == false)
-                T_CellStart = T_LastOffStart;
+            // If we've no phase lock, every CARRIER_OFF is potentially the start of a new second/cell
+            if (pRx->bPhaseLocked == false)
+                pRx->T_CellStart = pRx->T_LastOffStart;
 
-            switch( eLastOnWidth )
+            switch( pRx->eLastOnWidth )
             {
                 case eWidth_500:
-                    if (bHalfSync == true)
+                    if (pRx->bHalfSync == true)
                     {
                         // We've had 500 ON after 500 OFF. This a good SYNC so we're at the start of the second #1 cell.
                         LOGprintf(LOG_SYNC_MSG, "SYNC\n");
-                        ClientEventNotify( MSF_EVENT_SYNC );
-                        bSyncedFlag = true;
-                        T_CellStart = T_LastOffStart;
-                        // This is definitely the start of a new frame. If we just received a full frame, try to decode it.
-                        if (nBitNum==60)
-                            bResyncNeeded = !DecodeFrame();
-                        nBitNum = 1;
+                        STAT_COUNT( MSF_STAT_SYNC_FOUND );
+                        SetSyncState( pRx, true );
+                        pRx->bPhaseLocked = true;
+                        pRx->bHalfSync    = false;
+                        pRx->T_CellStart  = pRx->T_LastOffStart;
+                        // This is definitely the start of a new frame. Whatever cells of it we received since the
+                        // 1 Hz phase was found are in the shift registers, any before that are erased, so try to
+                        // decode it. The SYNC is good even if the frame isn't, so there's no need to reSYNC if it fails.
+                        HardEndFrame( pRx, pRx->T_MinuteStart );
+                        pRx->nBitNum = 1;
+                        SecondMarker( pRx, pRx->T_LastOffStart );
                     }
                     else
                     {
                         // 500ms CARRIER_ON without a preceding 500ms CARRIER_OFF shouldn't happen.
                         LOGprintf(LOG_SYNC_MSG, "Missing HALF SYNC\n");
-                        bResyncNeeded = true;
+                        STAT_COUNT( MSF_STAT_MISSING_HALF_SYNC );
+                        bError = true;
                     }
                     break;
 
                 // A & B both high followed by 700ms high
                 case eWidth_900:
-                    if (!bSyncedFlag) break;
-                    setBit(A_bits, nBitNum, false);
-                    setBit(B_bits, nBitNum++, false);
-                    T_CellStart = T_LastOffStart;
+                    pRx->bCellA = false;
+                    pRx->bCellB = false;
+                    bCellEnd = true;
                     break;
 
                 // A low, B high followed by 700ms high
                 case eWidth_800:
-                    if (!bSyncedFlag) break;
-                    setBit(A_bits, nBitNum, true);
-                    setBit(B_bits, nBitNum++, false);
-                    T_CellStart = T_LastOffStart;
+                    pRx->bCellA = true;
+                    pRx->bCellB = false;
+                    bCellEnd = true;
                     break;
 
                 // A & B both low followed by 700ms high
                 case eWidth_700:
-                    if (!bSyncedFlag) break;
-                    setBit(B_bits, nBitNum++, true);
-                    T_CellStart = T_LastOffStart;
+                    pRx->bCellB = true;
+                    bCellEnd = true;
                     break;
 
                 // @ the end of A high, start of B low ?
                 case eWidth_100:
-                    if (!bSyncedFlag) break;
-                    if (GetWidth(event_time - T_CellStart)==eWidth_200)
+                    if (!pRx->bPhaseLocked) break;
+                    if (GetWidth(pRx, CellOffsetTable, INTERVAL_OFF_TO_OFF, TICKS_TO_MS(event_time - pRx->T_CellStart))==eWidth_200)
                     {
-                        setBit(A_bits, nBitNum, false);
-                        setBit(B_bits, nBitNum++, true);
+                        pRx->bCellA = false;
+                        pRx->bCellB = true;
                     }
                     else
-                        bResyncNeeded = true;
+                        bError = true;
                     break;
 
                 default:
-                    LOGprintf(LOG_EDGE_ERROR, "Bad CARRIER_ON width %d\n", event_time - T_LastOnStart);
-                    bResyncNeeded = true;
+                    LOGprintf(LOG_EDGE_ERROR, "Bad CARRIER_ON width %d\n", TICKS_TO_MS(event_time - pRx->T_LastOnStart));
+                    STAT_COUNT( MSF_STAT_BAD_WIDTH );
+                    bError = true;
                     break;
 
             } // switch(eLastOnWidth)
 
+            // Every cell ends with at least 700ms ON, so this CARRIER_OFF is a second marker
+            if (bCellEnd)
+            {
+                if (pRx->bPhaseLocked)
+                {
+                    HardEndCell( pRx, false, pRx->T_CellStart );
+                }
+                else
+                {
+                    LOGprintf(LOG_SYNC_MSG, "Second marker found\n");
+                    STAT_COUNT( MSF_STAT_SECOND_MARKER_FOUND );
+                    pRx->bPhaseLocked = true;
+                }
+
+                pRx->T_CellStart = pRx->T_LastOffStart;
+                SecondMarker( pRx, pRx->T_LastOffStart );
+            }
+
         } // case CARRIER_OFF
         break;
 
@@ -604,145 +3309,692 @@ static bool bResyncNeeded = true;
         case CARRIER_ON:
         {
             // Update state tracking variables
-            T_LastOnStart = event_time;
-            eLastOffWidth = GetWidth(event_time - T_LastOffStart);
+            pRx->T_LastOnStart = event_time;
+            pRx->eLastOffWidth = GetWidth(pRx, OffWidthTable, INTERVAL_OFF_TO_ON, TICKS_TO_MS(event_time - pRx->T_LastOffStart));
 
             // Show carrier is now ON and the last OFF duration
-            LOGprintf(LOG_CARRIER_EVENT, "ON %d\n", event_time - T_LastOffStart);
+            LOGprintf(LOG_CARRIER_EVENT, "ON %d\n", TICKS_TO_MS(event_time - pRx->T_LastOffStart));
+
+            if (pRx->bCellError)
+                break;
 
             // Where in the cell/second is this CARRIER_ON edge?
-            switch (GetWidth(event_time - T_CellStart))
+            eCellOffset = GetWidth(pRx, CellOffsetTable, INTERVAL_OFF_TO_ON, TICKS_TO_MS(event_time - pRx->T_CellStart));
+
+            switch (eCellOffset)
             {
                 // Check for SYNC condition
                 case eWidth_500:
-                    if (eLastOffWidth == eWidth_500)
+                    if (pRx->eLastOffWidth == eWidth_500)
                     {
                         // This event is a CARRIER_ON 500ms from cell start immediately after a 500ms OFF.
                         // If the carrier stays ON for 500ms this will be a valid SYNC.
-                        bHalfSync = true;
+                        pRx->bHalfSync = true;
+                        pRx->T_MinuteStart = pRx->T_CellStart;
                     }
                     else
                     {
                         // We just had CARRIER_ON 500ms from cell start, but the preceding OFF wasn't 500ms.
                         // This is invalid & should never happen.
                         LOGprintf(LOG_SYNC_MSG, "Unexpected HALF SYNC\n");
-                        bResyncNeeded = true;
+                        STAT_COUNT( MSF_STAT_UNEXPECTED_HALF_SYNC );
+                        bError = true;
                     }
                     break;
 
                 case eWidth_100:
-                    if (!bSyncedFlag) break;
-                    setBit(A_bits, nBitNum, false);
+                    if (!pRx->bPhaseLocked) break;
+                    pRx->bCellA = false;
                     break;
 
                 case eWidth_200:
-                    if (!bSyncedFlag) break;
-                    setBit(A_bits, nBitNum, true);
-                    setBit(B_bits, nBitNum, false);
+                    if (!pRx->bPhaseLocked) break;
+                    pRx->bCellA = true;
+                    pRx->bCellB = false;
                     break;
 
                 case eWidth_300:
-                    if (!bSyncedFlag) break;
-                    setBit(B_bits, nBitNum, false);
-                    if (eLastOffWidth == eWidth_100)
-                        setBit(A_bits, nBitNum, false);
-                    else if (eLastOffWidth == eWidth_300)
-                        setBit(A_bits, nBitNum, true);
+                    if (!pRx->bPhaseLocked) break;
+                    pRx->bCellB = false;
+                    if (pRx->eLastOffWidth == eWidth_100)
+                        pRx->bCellA = false;
+                    else if (pRx->eLastOffWidth == eWidth_300)
+                        pRx->bCellA = true;
                     else
-                        bResyncNeeded = true;
+                        bError = true;
                     break;
 
                 default:
-                    LOGprintf(LOG_EDGE_ERROR, "Bad CARRIER_ON offset %d\n", event_time - T_CellStart);
-                    bResyncNeeded = true;
+                    LOGprintf(LOG_EDGE_ERROR, "Bad CARRIER_ON offset %d\n", TICKS_TO_MS(event_time - pRx->T_CellStart));
+                    STAT_COUNT( MSF_STAT_BAD_OFFSET );
+                    bError = true;
                     break;
             } // switch
         } // case CARRIER_ON
         break;
 
+        case CARRIER_EDGES_LOST:
+            // The cell timing is still good, just not the edges in this cell
+            LOGprintf(LOG_EDGE_ERROR, "Edge queue overflow!\n");
+            STAT_COUNT( MSF_STAT_EDGES_LOST );
+            bError = true;
+            break;
+
         default:
             LOGprintf(LOG_EDGE_ERROR, "Unknown carrier event!\n");
-            bResyncNeeded = true;
+            STAT_COUNT( MSF_STAT_UNKNOWN_EVENT );
+            bError = true;
             break;
 
     } // switch event->level
 
 
 
-    if (bResyncNeeded)
+    if (bError)
+    {
+        // Only this cell is lost if we're still tracking the second markers
+        pRx->bHalfSync  = false;
+        pRx->bCellError = pRx->bPhaseLocked;
+    }
+
+
+#if (MSF_ENABLE_QUALITY == 1)
+    // Measure each edge once, where it falls in the cell, as the soft engine does. The second
+    // markers are the reference, so they aren't measured themselves.
+    if (bMeasure && (pRx->T_CellStart != event_time))
+    {
+#if (MSF_ADAPTIVE_MARGINS == 1)
+        if (event_level == CARRIER_ON)
+            msOffset = AdaptWidth( pRx, msOffset, INTERVAL_OFF_TO_ON );
+#endif
+        bInMargin = CellEdgeError( (int32_t) msOffset, &error );
+        QualityEdge( pRx, error, bInMargin );
+    }
+#endif
+
+
+    // Work out the earliest the next edge could arrive. Only a CARRIER_ON 200, 300 or 500ms
+    // into the cell is followed by a long gap, until the CARRIER_OFF that starts the next cell.
+    if ((event_level == CARRIER_ON) || (event_level == CARRIER_OFF))
+    {
+        msNextEdge = MIN_EDGE_INTERVAL;
+
+        if ((event_level == CARRIER_ON) && (pRx->bPhaseLocked || pRx->bHalfSync) && (eCellOffset >= eWidth_200))
+            msNextEdge = CELL_LENGTH - (eCellOffset * 100);
+
+        pRx->T_NextEdgeDeadline = event_time + MS_TO_TICKS(msNextEdge - PULSE_MARGIN);
+    }
+}
+
+
+#else // MSF_ENGINE_SOFT
+
+// The slot boundaries in a cell in ms, and the carrier OFF time in each slot for every legal cell.
+// Patterns are indexed by (A << 1) | B with the minute marker last.
+#define     SOFT_PATTERN_MINUTE     4
+
+STATIC const uint16_t SoftSlotEnd[ SOFT_NUM_SLOTS ] = { 100, 200, 300, 500, 1000 };
+
+STATIC const uint16_t SoftPatternOffTime[ SOFT_NUM_PATTERNS ][ SOFT_NUM_SLOTS ] = {
+    { 100,   0,   0,   0, 0 },          // A=0 B=0
+    { 100,   0, 100,   0, 0 },          // A=0 B=1
+    { 100, 100,   0,   0, 0 },          // A=1 B=0
+    { 100, 100, 100,   0, 0 },          // A=1 B=1
+    { 100, 100, 100, 200, 0 }           // Minute marker, 500ms OFF
+};
+
+
+
+
+/**
+ * Give up on the 1 Hz phase and start looking for the second markers again.
+ */
+STATIC void
+SoftLoseSync( sReceiver* pRx )
+{
+    if (pRx->bSyncedFlag)
     {
-        // If there were any errors we must reSYNC
         LOGprintf(LOG_SYNC_MSG, "SYNC lost\n");
-        ClientEventNotify( MSF_EVENT_SYNC_LOST );
+        STAT_COUNT( MSF_STAT_SYNC_LOST );
+    }
+
+    SetSyncState( pRx, false );
+    pRx->bSoftPhaseLocked = false;
+    pRx->nSoftBitNum      = 0;
+    pRx->nSoftBadCells    = 0;
+    pRx->nSoftOffHistory  = 0;
+}
+
+
+
+/**
+ * Measure how long the carrier was OFF in each slot of the current cell.
+ */
+STATIC void
+SoftMeasureCell( sReceiver* pRx, uint32_t* pOffTime )
+{
+uint32_t level = pRx->SoftCellStartLevel;
+uint32_t from = 0;
+uint32_t to, lo, hi, slot;
+unsigned edge;
+
+    for (slot = 0 ; slot < SOFT_NUM_SLOTS ; slot++)
+        pOffTime[ slot ] = 0;
+
+    for (edge = 0 ; edge <= pRx->nSoftCellEdges ; edge++)
+    {
+        to = (edge < pRx->nSoftCellEdges) ? pRx->SoftCellEdgeOffset[ edge ] : CELL_LENGTH;
+
+        // Share the OFF interval [from, to) between the slots it overlaps
+        if (level == CARRIER_OFF)
+        {
+            for (slot = 0, lo = 0 ; slot < SOFT_NUM_SLOTS ; lo = SoftSlotEnd[ slot++ ])
+            {
+                hi = SoftSlotEnd[ slot ];
+                if ((from < hi) && (to > lo))
+                    pOffTime[ slot ] += ((to < hi) ? to : hi) - ((from > lo) ? from : lo);
+            }
+        }
+
+        if (edge < pRx->nSoftCellEdges)
+            level = pRx->SoftCellEdgeLevel[ edge ];
+        from = to;
+    }
+}
+
+
+
+/**
+ * Score the current cell against each legal pattern. The cost of a pattern is the number of
+ * milliseconds of carrier that don't match it, and the most likely pattern has the lowest cost.
+ * The confidence in a bit is how much more it would cost to flip it.
+ *
+ * Returns the most likely pattern.
+ */
+STATIC unsigned
+SoftScoreCell( sReceiver* pRx, uint32_t* pBestCost, uint8_t* pConfA, uint8_t* pConfB )
+{
+uint32_t offtime[ SOFT_NUM_SLOTS ];
+uint32_t cost[ SOFT_NUM_PATTERNS ];
+uint32_t diff;
+unsigned pattern, slot, best = 0;
+
+    SoftMeasureCell( pRx, offtime );
+
+    for (pattern = 0 ; pattern < SOFT_NUM_PATTERNS ; pattern++)
+    {
+        cost[ pattern ] = 0;
+        for (slot = 0 ; slot < SOFT_NUM_SLOTS ; slot++)
+        {
+            diff = (offtime[ slot ] > SoftPatternOffTime[ pattern ][ slot ])
+                   ? offtime[ slot ] - SoftPatternOffTime[ pattern ][ slot ]
+                   : SoftPatternOffTime[ pattern ][ slot ] - offtime[ slot ];
+            cost[ pattern ] += diff;
+        }
+
+        if (cost[ pattern ] < cost[ best ])
+            best = pattern;
+    }
+
+    *pBestCost = cost[ best ];
+
+    if (best == SOFT_PATTERN_MINUTE)
+    {
+        // Against the nearest data pattern, A=1 B=1
+        diff = cost[ 3 ] - cost[ best ];
+        *pConfA = *pConfB = (diff > SOFT_MAX_CONFIDENCE) ? SOFT_MAX_CONFIDENCE : diff;
+    }
+    else
+    {
+        diff = cost[ best ^ 2 ] - cost[ best ];
+        *pConfA = (diff > SOFT_MAX_CONFIDENCE) ? SOFT_MAX_CONFIDENCE : diff;
+        diff = cost[ best ^ 1 ] - cost[ best ];
+        *pConfB = (diff > SOFT_MAX_CONFIDENCE) ? SOFT_MAX_CONFIDENCE : diff;
+    }
+
+    return best;
+}
+
+
+
+/**
+ * Use the confidence of each bit to correct the frame before decoding it. Errors in the fixed
+ * A52-A59 marker and a single error in each parity group are corrected if the bit at fault
+ * is uncertain enough.
+ *
+ * Returns false if the frame can't be recovered.
+ */
+STATIC bool
+SoftRecoverFrame( sReceiver* pRx )
+{
+uint32_t marker_errors = FRAME_FIELD( pRx->A_bits, 52, 59 ) ^ FRAME_MARKER;
+unsigned group, bitnum, weakest;
+uint8_t confidence = SOFT_MAX_CONFIDENCE;
+bool bWeakestIsB;
+
+    // Bits A52 to A59 are fixed so any uncertain ones can just be set
+    for (bitnum = 52 ; bitnum <= 59 ; bitnum++)
+    {
+        if (marker_errors & (1 << (59 - bitnum)))
+        {
+            if (pRx->SoftConfA[ bitnum ] >= SOFT_RECOVER_CONFIDENCE)
+            {
+                LOGprintf(LOG_BCD_ERROR, "A%u is wrong!\n", bitnum);
+                return false;
+            }
+            setBit( &pRx->A_bits, bitnum, !getBit( pRx->A_bits, bitnum ));
+        }
+    }
+
+    for (group = 0 ; group < sizeof(ParityGroups) / sizeof(ParityGroups[0]) ; group++)
+    {
+        uint64_t mask = FRAME_MASK( ParityGroups[group].from, ParityGroups[group].to );
+
+        if (CheckOddParity( (pRx->A_bits & mask) ^ (pRx->B_bits & FRAME_BIT(ParityGroups[group].parity)) ))
+            continue;
+
+        // Find the least certain bit in the group and flip it
+        weakest = ParityGroups[group].parity;
+        bWeakestIsB = true;
+        for (bitnum = ParityGroups[group].from ; bitnum <= ParityGroups[group].to ; bitnum++)
+        {
+            if (pRx->SoftConfA[ bitnum ] < ((bWeakestIsB) ? pRx->SoftConfB[ weakest ] : pRx->SoftConfA[ weakest ]))
+            {
+                weakest = bitnum;
+                bWeakestIsB = false;
+            }
+        }
 
-        nBitNum = 1;
-        bHalfSync = false;
-        bSyncedFlag = false;
-        bResyncNeeded = false;
+        if (((bWeakestIsB) ? pRx->SoftConfB[ weakest ] : pRx->SoftConfA[ weakest ]) >= SOFT_RECOVER_CONFIDENCE)
+        {
+            LOGprintf(LOG_BCD_ERROR, "A%u to A%u fail parity check with B%u!\n",
+                       ParityGroups[group].from, ParityGroups[group].to, ParityGroups[group].parity);
+            return false;
+        }
+
+        LOGprintf(LOG_BCD_ERROR, "Corrected %c%u\n", (bWeakestIsB) ? 'B' : 'A', weakest);
+        if (bWeakestIsB)
+            setBit( &pRx->B_bits, weakest, !getBit( pRx->B_bits, weakest ));
+        else
+            setBit( &pRx->A_bits, weakest, !getBit( pRx->A_bits, weakest ));
     }
 
+    // The frame is only as good as its least certain bit
+    for (bitnum = 1 ; bitnum <= 59 ; bitnum++)
+    {
+        if (pRx->SoftConfA[ bitnum ] < confidence)
+            confidence = pRx->SoftConfA[ bitnum ];
+        if ((bitnum >= 54) && (pRx->SoftConfB[ bitnum ] < confidence))
+            confidence = pRx->SoftConfB[ bitnum ];
+    }
+    pRx->FrameConfidence = confidence;
+
+    return true;
 }
 
 
 
+#if (MSF_ENABLE_QUALITY == 1) || (MSF_ADAPTIVE_MARGINS == 1)
+
+/**
+ * Measure each edge in the cell with CellEdgeError(). The CARRIER_ON offsets have already
+ * been corrected for the learned bias.
+ */
+STATIC void
+SoftCellEdgeErrors( sReceiver* pRx )
+{
+unsigned edge;
+int32_t  error;
+bool     bInMargin;
+
+    for (edge = 0 ; edge < pRx->nSoftCellEdges ; edge++)
+    {
+        bInMargin = CellEdgeError( (int32_t) pRx->SoftCellEdgeOffset[ edge ], &error );
+
+#if (MSF_ADAPTIVE_MARGINS == 1)
+        // The soft engine scores the cell as a whole, so it only uses the learned bias
+        if (bInMargin)
+            (void) AdaptInterval( pRx, (pRx->SoftCellEdgeLevel[ edge ] == CARRIER_ON) ? INTERVAL_OFF_TO_ON : INTERVAL_OFF_TO_OFF,
+                                  error );
+#endif
+
+#if (MSF_ENABLE_QUALITY == 1)
+        QualityEdge( pRx, error, bInMargin );
+#endif
+    }
+}
+
+#endif
+
 
 
 /**
- * This MSF radio ISR just passes the new carrier signal level to
- * the HandleCarrierEvent() function.
+ * The current cell is complete. Work out which bits it carried, or if it's the minute marker
+ * decode the frame just received.
  */
 STATIC void
-RadioGpioIntHandler( void )
+SoftEndCell( sReceiver* pRx )
 {
-uint32_t carrier_level;
+uint32_t cost;
+uint8_t  confA, confB;
+unsigned pattern = SoftScoreCell( pRx, &cost, &confA, &confB );
+uint64_t erased = FRAME_ALL_ERASED;
+unsigned bitnum;
 
-    uint32_t int_status = GPIOIntStatus( RADIO_PORT_BASE, true );
-    GPIOIntClear( RADIO_PORT_BASE, RADIO_DATA_BIT );
+#if (MSF_ENABLE_QUALITY == 1) || (MSF_ADAPTIVE_MARGINS == 1)
+    SoftCellEdgeErrors( pRx );
+#endif
+
+    if (cost > SOFT_BAD_CELL_COST)
+    {
+        LOGprintf(LOG_EDGE_ERROR, "Bad cell %u cost %u\n", pRx->nSoftBitNum, cost);
+        STAT_COUNT( MSF_STAT_BAD_CELL );
+
+        // Before SYNC a bad cell probably means we're locked to the wrong edges
+        if ((!pRx->bSyncedFlag) || (++pRx->nSoftBadCells >= SOFT_MAX_BAD_CELLS))
+        {
+            SoftLoseSync( pRx );
+            return;
+        }
+        confA = confB = 0;
+    }
+    else
+    {
+        pRx->nSoftBadCells = 0;
+    }
 
-    if (int_status & RADIO_DATA_BIT)
+    // Once SYNC'd the cell after bit 59 is the minute marker however it looks. Otherwise
+    // a confident minute marker re-aligns the frame, covering leap seconds and first SYNC.
+    if (((pRx->bSyncedFlag) && (pRx->nSoftBitNum == 60)) ||
+        ((pattern == SOFT_PATTERN_MINUTE) && (confA >= SOFT_RECOVER_CONFIDENCE)))
     {
-        carrier_level = (GPIOPinRead(RADIO_PORT_BASE, RADIO_DATA_BIT)) ? CARRIER_OFF : CARRIER_ON;
-        HandleCarrierEvent( carrier_level );
+        if (!pRx->bSyncedFlag)
+        {
+            LOGprintf(LOG_SYNC_MSG, "SYNC\n");
+            STAT_COUNT( MSF_STAT_SYNC_FOUND );
+            SetSyncState( pRx, true );
+        }
+
+        if (pRx->nSoftBitNum == 60)
+        {
+#if (MSF_ENABLE_QUALITY == 1)
+            QualityFrame( pRx, 0 );
+#endif
+            // The bad cells are erased if parity can't correct them
+            erased = 0;
+            if (!SoftRecoverFrame( pRx ))
+            {
+                for (bitnum = 1 ; bitnum <= 59 ; bitnum++)
+                {
+                    if (pRx->SoftConfA[ bitnum ] == 0)
+                        erased |= FRAME_BIT(bitnum);
+                }
+            }
+        }
+
+        MinuteMarker( pRx, erased, pRx->T_SoftCellStart );
 
-        SetLED( carrier_level );
+        pRx->nSoftBitNum = 1;
+        return;
+    }
+
+    if (pRx->nSoftBitNum == 0)
+        return;
+
+    if (pRx->nSoftBitNum >= 60)
+    {
+        // Too many cells without a minute marker, wait for the next one
+        LOGprintf(LOG_SYNC_MSG, "Missing minute marker\n");
+        STAT_COUNT( MSF_STAT_MISSING_MINUTE );
+        pRx->nSoftBitNum = 0;
+        return;
     }
+
+    setBit( &pRx->A_bits, pRx->nSoftBitNum, (pattern & 2) ? true : false );
+    setBit( &pRx->B_bits, pRx->nSoftBitNum, (pattern & 1) ? true : false );
+    pRx->SoftConfA[ pRx->nSoftBitNum ] = confA;
+    pRx->SoftConfB[ pRx->nSoftBitNum ] = confB;
+    pRx->nSoftBitNum++;
 }
 
 
 
 /**
- * Configure the GPIO port to interface with the MSF radio card
+ * Start recording a new cell at the given time
  */
 STATIC void
-InitRadioInterface( void )
+SoftStartCell( sReceiver* pRx, uint32_t cell_start, uint32_t start_level )
+{
+    pRx->T_SoftCellStart    = cell_start;
+    pRx->SoftCellStartLevel = start_level;
+    pRx->nSoftCellEdges     = 0;
+}
+
+
+
+/*******************************************************************
+* NAME  SoftCarrierEvent
+*
+* DESCRIPTION
+*       Soft decision decoder for changes in the carrier signal from the radio
+*
+* PARAMETERS
+*       uint32_t    event_level     CARRIER_ON or CARRIER_OFF GPIO pin level
+*       uint32_t    event_time      Tick count latched when the edge occurred
+*
+* OUTPUTS
+*       If a valid time is decoded it is copied to the users pUserDateTime
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*
+* 1. Find the 1 Hz phase from two CARRIER_OFF edges one second apart.
+* 2. Record every edge in the cell, relative to the cell start.
+* 3. The CARRIER_OFF edge near the end of the cell is the next second marker. If it's
+*    missing, flywheel on to where it should have been.
+* 4. Score the completed cell against every legal pattern and keep the most likely
+*    bits along with their confidence.
+* 5. At the minute marker, correct the frame using the bit confidences and decode it.
+*
+* Glitches and out of margin edges only reduce the confidence of the bits in that cell.
+*
+*/
+STATIC void
+SoftCarrierEvent( sReceiver* pRx, uint32_t event_level, uint32_t event_time )
 {
-    // Enable the GPIO port
-    SysCtlPeripheralEnable(RADIO_GPIO_SYSCTL_PERIPH);
-    SysCtlPeripheralReset(RADIO_GPIO_SYSCTL_PERIPH);
-    while(!SysCtlPeripheralReady( RADIO_GPIO_SYSCTL_PERIPH ));
+uint32_t offset;
+unsigned index;
+
+    if ((event_level != CARRIER_ON) && (event_level != CARRIER_OFF))
+    {
+        LOGprintf(LOG_EDGE_ERROR, "Edge queue overflow!\n");
+        STAT_COUNT( MSF_STAT_EDGES_LOST );
+        SoftLoseSync( pRx );
+        return;
+    }
 
-    // Configure the required pins
-    GPIOPinTypeGPIOOutput( RADIO_PORT_BASE, RADIO_ENABLE_BIT );
-    GPIODirModeSet( RADIO_PORT_BASE, RADIO_ENABLE_BIT, GPIO_DIR_MODE_OUT );
-    GPIOPadConfigSet(RADIO_PORT_BASE, RADIO_ENABLE_BIT, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD);
-    GPIOPinTypeGPIOInput( RADIO_PORT_BASE, RADIO_DATA_BIT);
-    GPIODirModeSet( RADIO_PORT_BASE, RADIO_DATA_BIT, GPIO_DIR_MODE_IN );
+    LOGprintf(LOG_CARRIER_EVENT, (event_level == CARRIER_OFF) ? "OFF\n" : "ON\n");
+
+    if (pRx->bSoftPhaseLocked)
+    {
+        offset = TICKS_TO_MS(event_time - pRx->T_SoftCellStart);
+
+        // Flywheel over any missing second markers, carrying the signal level into the next cell
+        while (offset >= (CELL_LENGTH + PULSE_MARGIN))
+        {
+            SoftEndCell( pRx );
+            if ((!pRx->bSoftPhaseLocked) || (++pRx->nSoftMissedMarkers > SOFT_MAX_FLYWHEEL))
+            {
+                SoftLoseSync( pRx );
+                break;
+            }
+            SoftStartCell( pRx, pRx->T_SoftCellStart + MS_TO_TICKS(CELL_LENGTH),
+                           (pRx->nSoftCellEdges) ? pRx->SoftCellEdgeLevel[ pRx->nSoftCellEdges - 1 ] : pRx->SoftCellStartLevel );
+            offset -= CELL_LENGTH;
+        }
+    }
 
-    // This pin must be low to enable the output bit stream. Leave it high (disabled) for now.
-    GPIOPinWrite(RADIO_PORT_BASE, RADIO_ENABLE_BIT, RADIO_ENABLE_BIT );
+    if (pRx->bSoftPhaseLocked)
+    {
+        if ((event_level == CARRIER_OFF) && (offset > (CELL_LENGTH - PULSE_MARGIN)))
+        {
+            // This is the next second marker
+            SoftEndCell( pRx );
+            SoftStartCell( pRx, event_time, CARRIER_OFF );
+            SecondMarker( pRx, event_time );
+            pRx->nSoftMissedMarkers = 0;
+        }
+        else if (pRx->nSoftCellEdges < SOFT_MAX_CELL_EDGES)
+        {
+#if (MSF_ADAPTIVE_MARGINS == 1)
+            if (event_level == CARRIER_ON)
+                offset = AdaptWidth( pRx, offset, INTERVAL_OFF_TO_ON );
+#endif
+            pRx->SoftCellEdgeOffset[ pRx->nSoftCellEdges ] = offset;
+            pRx->SoftCellEdgeLevel[ pRx->nSoftCellEdges++ ] = event_level;
+        }
+    }
+    else if (event_level == CARRIER_OFF)
+    {
+        // Every second starts with CARRIER_OFF. Lock on if this one is a second after an earlier one.
+        for (index = 0 ; (index < pRx->nSoftOffHistory) && (index < SOFT_OFF_HISTORY) ; index++)
+        {
+            offset = TICKS_TO_MS(event_time - pRx->T_SoftOffHistory[ index ]);
+            if ((offset > (CELL_LENGTH - PULSE_MARGIN)) && (offset < (CELL_LENGTH + PULSE_MARGIN)))
+            {
+                pRx->bSoftPhaseLocked   = true;
+                pRx->nSoftBitNum        = 0;
+                pRx->nSoftMissedMarkers = 0;
+                SoftStartCell( pRx, event_time, CARRIER_OFF );
+                break;
+            }
+        }
 
-    // Configure GPIO interrupt for both rising & falling edges on the input pin
-    GPIOIntRegister( RADIO_PORT_BASE, RadioGpioIntHandler );
-    GPIOIntTypeSet( RADIO_PORT_BASE, RADIO_DATA_BIT, GPIO_BOTH_EDGES );
-    GPIOIntEnable( RADIO_PORT_BASE, RADIO_DATA_BIT );
+        pRx->T_SoftOffHistory[ pRx->nSoftOffHistory++ % SOFT_OFF_HISTORY ] = event_time;
+    }
 
-    IntEnable( RADIO_INT_GPIO );
+    // Work out the earliest the next edge could arrive, as the hard engine does. A CARRIER_ON
+    // 200, 300 or 500ms into the cell is followed by a long gap, until the next second marker.
+    if ((pRx->bSoftPhaseLocked) && (event_level == CARRIER_ON) && (offset >= (200 - PULSE_MARGIN)))
+        pRx->T_NextEdgeDeadline = pRx->T_SoftCellStart + MS_TO_TICKS(CELL_LENGTH - PULSE_MARGIN);
+    else
+        pRx->T_NextEdgeDeadline = event_time + MS_TO_TICKS(MIN_EDGE_INTERVAL - PULSE_MARGIN);
 }
 
+#endif // MSF_DECODER_ENGINE
+
 
 
 
 
+/************************************************************************************************************
+ *      RADIO INTERFACE ENTRY POINTS
+ ************************************************************************************************************/
+
+
+/*******************************************************************
+* NAME
+*       MSF_QueueCarrierEdge()
+*
+* DESCRIPTION
+*       Queue a timestamped carrier edge for MSF_Process()
+*
+* PARAMETERS
+*       unsigned    receiver        0 to MSF_NUM_RECEIVERS - 1
+*       uint32_t    level           Radio data pin level after the edge
+*       uint32_t    event_time      Tick count latched when the edge occurred
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*
+* Called by the radio ISR in radio.c, or by the host replay tool. It's the
+* only producer for that receiver's edge queue. If the queue is full the
+* edge is dropped, and a CARRIER_EDGES_LOST entry goes ahead of the next
+* edge queued so the decoder starts again at the point edges were lost.
+* Edges for a receiver that doesn't exist are ignored.
+* Each queued edge calls MSF_EDGE_QUEUED_HOOK(), see config.h.
+*
+********************************************************************/
+void
+MSF_QueueCarrierEdge( unsigned receiver, uint32_t level, uint32_t event_time )
+{
+    sReceiver* pRx;
+    sEdgeEvent edge;
+
+    if (receiver >= MSF_NUM_RECEIVERS)
+        return;
+
+    pRx = &Receivers[ receiver ];
+
+    edge.time  = event_time;
+
+    STAT_INC( Edges );
+
+    // Mark the gap left by dropped edges, once there's room for it and this edge
+    if (pRx->EdgeOverflowCount != pRx->QueuedOverflowCount)
+    {
+        if (Ring_Space(&pRx->EdgeQueue) < (2 * sizeof(edge)))
+        {
+            pRx->EdgeOverflowCount++;
+            return;
+        }
+
+        edge.level = CARRIER_EDGES_LOST;
+        Ring_Put(&pRx->EdgeQueue, &edge, sizeof(edge));
+        pRx->QueuedOverflowCount = pRx->EdgeOverflowCount;
+    }
+
+    edge.level = (level) ? CARRIER_OFF : CARRIER_ON;
+
+    if (!Ring_Put(&pRx->EdgeQueue, &edge, sizeof(edge)))
+    {
+        pRx->EdgeOverflowCount++;
+    }
+    else
+    {
+        MSF_EDGE_QUEUED_HOOK();
+    }
+}
+
+
+
+#if (MSF_ENABLE_STATS == 1)
 
+/*******************************************************************
+* NAME
+*       MSF_CountRadioIsr()
+*
+* DESCRIPTION
+*       Add one run of the radio ISR to the statistics
+*
+* PARAMETERS
+*       uint32_t    start_cycles    Radio_GetCycleCount() on entry to the ISR
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*
+* Call at the end of the radio ISR. With more than one receiver the ISR
+* is shared, so it's counted in receiver 0's statistics.
+*
+********************************************************************/
+void
+MSF_CountRadioIsr( uint32_t start_cycles )
+{
+    sReceiver* pRx = &Receivers[ 0 ];
 
+    StatAddCycles( &pRx->Stats.RadioIsr, start_cycles );
+}
 
+#endif
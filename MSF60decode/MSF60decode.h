@@ -15,6 +15,19 @@
 
 
 
+/**
+ * How a decoded frame was checked against the time already known, see MSF_FRAME_PREDICTION in config.h.
+ * This is how plausible the date/time is, in increasing order, and MSF_GetDecodeConfidence() how
+ * sure the decoder was of its bits. A predicted frame matched the clock's Unix time and DST bit.
+ */
+typedef enum {
+    MSF_FRAME_UNCONFIRMED = 0,              // Nothing predicted it, e.g. the first after reset
+    MSF_FRAME_CONFIRMED,                    // It followed on from an unconfirmed frame
+    MSF_FRAME_PREDICTED                     // It was the minute the free running clock predicted
+} eMSFFrameCheck;
+
+
+
 /**
  * The decoder returns the date/time information in this structure
  */
@@ -29,6 +42,13 @@ typedef struct
     uint8_t  Minute;                        // 0-59
     uint8_t  DOW;                           // 0-6 Day Of Week. Sunday = 0
     uint8_t  DST;                           // Daylight Savings Time active, 0 or 1
+    uint8_t  FrameCheck;                    // eMSFFrameCheck
+    int8_t   DUT1;                          // UT1 - UTC in tenths of a second, -8 to +8, from B1 to B16
+    uint8_t  DUT1Valid;                     // 0 if B1 to B16 didn't make sense, DUT1 is then from an earlier frame
+    uint8_t  DSTWarning;                    // B53, a change to or from BST is due at the next 01:00 UTC
+    uint32_t UnixTime;                      // The same minute as UTC seconds since 1st Jan 1970
+    uint64_t A_bits;                        // The whole frame as received, bit n of the frame is bit 63 - n
+    uint64_t B_bits;
 } sMSFDateTime;
 
 
@@ -44,6 +64,121 @@ typedef enum {
 
 
 
+/**
+ * How good the time from MSF_GetTime() is
+ */
+typedef enum {
+    MSF_TIME_INVALID            = 0,        // No time has been decoded yet
+    MSF_TIME_HOLDOVER           = 1,        // Free running since the last second marker
+    MSF_TIME_LOCKED             = 2         // Disciplined by the received second markers
+} eMSFTimeQuality;
+
+
+
+/**
+ * Free running time from MSF_GetTime()
+ */
+typedef struct
+{
+    uint32_t Seconds;                       // Seconds since 00:00:00 1st Jan 2000, UK civil time as broadcast
+    uint32_t UnixSeconds;                   // The same time as UTC seconds since 1st Jan 1970
+    uint16_t Milliseconds;                  // 0-999
+    uint8_t  Quality;                       // eMSFTimeQuality
+    uint32_t HoldoverSeconds;               // Seconds since the last second marker was received
+} sMSFTime;
+
+
+
+/**
+ * Cycle counts for one timed section of the decoder, see MSF_GetStats()
+ */
+typedef struct
+{
+    uint32_t Count;                         // Times the section ran
+    uint32_t MinCycles;                     // Shortest run, 0 if it hasn't run
+    uint32_t MaxCycles;                     // Longest run
+    uint64_t TotalCycles;                   // Mean is TotalCycles / Count
+} sMSFCycleStats;
+
+
+
+/**
+ * Decoder events counted by MSF_GetStats(), one for each reason a cell,
+ * frame or SYNC is lost
+ */
+typedef enum {
+    MSF_STAT_SYNC_FOUND = 0,                // Minute marker found, SYNC'd
+    MSF_STAT_SYNC_ON_MARKER_BITS,           // SYNC'd on the A52 to A59 marker bits
+    MSF_STAT_SYNC_LOST,                     // SYNC lost
+    MSF_STAT_MISSING_MINUTE,                // No minute marker after bit 59
+    MSF_STAT_MISSING_HALF_SYNC,             // 500ms CARRIER_ON without a 500ms CARRIER_OFF before it
+    MSF_STAT_UNEXPECTED_HALF_SYNC,          // CARRIER_ON 500ms into a cell that didn't start with 500ms OFF
+    MSF_STAT_SECOND_MARKERS_LOST,           // Too many cells lost in a row, the 1 Hz phase is lost
+    MSF_STAT_SECOND_MARKER_FOUND,           // 1 Hz phase found
+    MSF_STAT_SECOND_MARKER_OFF,             // Second marker too far from the free running clock
+    MSF_STAT_BAD_WIDTH,                     // CARRIER_ON pulse width out of margin
+    MSF_STAT_BAD_OFFSET,                    // CARRIER_ON edge offset in the cell out of margin
+    MSF_STAT_LOST_CELLS,                    // Cells lost between two edges
+    MSF_STAT_BAD_CELL,                      // Soft decoder cell not close to any pattern
+    MSF_STAT_EDGES_LOST,                    // The edge queue overflowed
+    MSF_STAT_UNKNOWN_EVENT,                 // Unknown carrier level
+    MSF_NUM_STAT_EVENTS
+} eMSFStatEvent;
+
+
+
+// The width histograms are indexed by the nominal width in 100ms units, [0] counts the invalid widths
+#define     MSF_STAT_WIDTH_BINS             10
+
+/**
+ * Decoder statistics from MSF_GetStats(). Counts wrap at 2^32.
+ */
+typedef struct
+{
+    sMSFCycleStats RadioIsr;                // Radio GPIO or capture timer ISR
+    sMSFCycleStats CarrierEvent;            // Decoder engine, per edge
+    sMSFCycleStats DecodeFrame;             // Frame validation & decode, including the client callbacks it makes
+    sMSFCycleStats ClientCallback;          // Client event callbacks
+
+    uint32_t Edges;                         // Carrier edges seen by the ISR
+    uint32_t EdgesLost;                     // Edges dropped because the queue was full
+    uint32_t EdgesMerged;                   // Edges the glitch filter dropped for not changing the carrier level
+    uint32_t GlitchesRejected;              // Pulses the glitch filter dropped for being too short
+    uint32_t OffWidths[ MSF_STAT_WIDTH_BINS ];   // CARRIER_OFF pulse width classifications
+    uint32_t OnWidths[ MSF_STAT_WIDTH_BINS ];    // CARRIER_ON pulse width classifications
+    uint32_t CellOffsets[ MSF_STAT_WIDTH_BINS ]; // Edge offset from the cell start classifications
+    uint32_t Events[ MSF_NUM_STAT_EVENTS ]; // eMSFStatEvent counts
+    uint32_t FramesDecoded;                 // Frames that passed validation
+    uint32_t MarkerFailures;                // Frames with bad A52 to A59 marker bits
+    uint32_t ParityFailures;                // Frames failing a parity check
+    uint32_t RangeFailures;                 // Frames with an impossible date/time
+    uint32_t VotedFailures;                 // Frames that still failed after a vote, see MSF_VOTE_FRAMES
+    uint32_t FramesHeld;                    // Frames held back until the next frame confirmed them
+} sMSFStats;
+
+
+
+/**
+ * Signal quality of one receiver from MSF_GetSignalQuality(). The edge error is how far an edge
+ * is from its nominal place in the cell, measured the same way by both engines. The second markers
+ * are the reference and aren't counted. The averages follow about the last 16 edges, frames or seconds.
+ */
+#define     MSF_QUALITY_ERROR_BINS  8       // 5 ms each, the last for edges out of margin
+
+typedef struct
+{
+    uint8_t  LockQuality;                   // 0-100, 0 without SYNC
+    uint8_t  EdgesInMargin;                 // 0-100% of edges near a legal place in the cell, a proxy for SNR
+    uint16_t EdgeErrorUs;                   // Mean edge error of those in margin, us
+    uint16_t BitErrorsPerMille;             // Estimated from the parity groups failed in each frame
+    int8_t   OnEdgeBiasMs;                  // Learned CARRIER_ON edge delay, see MSF_ADAPTIVE_MARGINS
+    uint8_t  MarginMs;                      // Width margin now in use by the hard engine
+    uint8_t  bInverted;                     // 1 if the receiver's output was found inverted, see MSF_DETECT_POLARITY
+    uint32_t ErrorHistogram[ MSF_QUALITY_ERROR_BINS ];  // Edges by edge error since MSF_InitDecoder()
+} sMSFSignalQuality;
+
+
+
 /**
  * Function type for event notifications
  */
@@ -62,6 +197,20 @@ void MSF_InitDecoder( sMSFDateTime* pdata );
 void MSF_EnableEventNotifications( MSF_EVENT_CALLBACK pfunc, uint32_t enable_mask );
 void MSF_EnableRadio( bool state );
 bool MSF_GetSyncState( void );
+uint32_t MSF_ReadDateTime( sMSFDateTime* pDateTime );
+uint32_t MSF_Process( void );
+uint32_t MSF_DispatchEvents( void );
+uint32_t MSF_GetWakeDeadline( void );
+uint8_t MSF_GetDecodeConfidence( void );
+eMSFTimeQuality MSF_GetTime( sMSFTime* pTime );
+bool MSF_GetClockDrift( int32_t* pDriftPpb );
+bool MSF_GetStats( sMSFStats* pStats );
+bool MSF_GetSignalQuality( unsigned receiver, sMSFSignalQuality* pQuality );
+
+// More than one receiver, see MSF_NUM_RECEIVERS in config.h
+bool MSF_GetReceiverSyncState( unsigned receiver );
+bool MSF_GetReceiverStats( unsigned receiver, sMSFStats* pStats );
+unsigned MSF_GetLeadReceiver( void );
 
 
 #endif // _MSF60DECODE_H_
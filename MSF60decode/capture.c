@@ -0,0 +1,354 @@
+/********************************************************************************
+ * @file    capture.c
+ * @author  Tony Hanratty
+ * @date    14-Oct-2026
+ *
+ * @brief   Records the raw radio edges for replay on a PC
+ *
+ * @notes   The radio ISR calls Capture_Edge() for every edge, before the decoder
+ *          sees it. It's a flag test when no capture is running and a divide,
+ *          a multiply and a 16 bit store when one is, so the timing recorded is
+ *          the timing the decoder gets. When the buffer is full capture stops.
+ *          The capture timer's timeout interrupt calls Capture_Idle() to record
+ *          long gaps before its wrapping tick count loses them.
+ *
+ *          The buffer is only written by the ISR and only up to CaptureEntries,
+ *          so it can be read back while a capture is still running.
+ *
+ ********************************************************************************/
+
+
+// System includes
+#include <stdbool.h>
+#include <stdint.h>
+
+// Our includes
+#include "config.h"
+#include "radio.h"
+
+// This file's include
+#include "capture.h"
+
+
+
+#if (MSF_CAPTURE_EDGES > 0)
+
+// Each entry is the pin level after the edge in bit 15 and the ms since the last edge in bits 0 to 14
+#define     CAPTURE_LEVEL_BIT       0x8000
+#define     CAPTURE_DELTA_MASK      0x7FFF
+
+// An entry with all the delta bits set is 32767 ms with no edge, for longer gaps
+#define     CAPTURE_DELTA_ESCAPE    CAPTURE_DELTA_MASK
+
+
+
+STATIC uint16_t CaptureBuffer[ MSF_CAPTURE_EDGES ];
+
+STATIC volatile bool     bCapturing = false;
+STATIC volatile uint32_t CaptureEntries = 0;            // Entries used in CaptureBuffer
+STATIC volatile uint32_t CaptureEdges = 0;              // Edges recorded
+
+STATIC uint32_t T_CaptureLast;                          // Tick count of the last edge, less the part of a ms not yet recorded
+STATIC uint32_t CaptureTicksPerMs = 1;
+
+
+
+/*******************************************************************
+* NAME
+*       Capture_Start()
+*
+* DESCRIPTION
+*       Empty the capture buffer and start recording edges
+*
+* PARAMETERS
+*       None
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*
+* Edge times are recorded from now. Any capture already in the buffer is lost.
+*
+********************************************************************/
+void
+Capture_Start( void )
+{
+    uint32_t mask = Radio_IntDisable();
+
+    CaptureTicksPerMs = Radio_GetTicksPerMs();
+    T_CaptureLast     = Radio_GetTickCount();
+    CaptureEntries    = 0;
+    CaptureEdges      = 0;
+    bCapturing        = true;
+
+    Radio_IntRestore( mask );
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Capture_Stop()
+*
+* DESCRIPTION
+*       Stop recording edges
+*
+* PARAMETERS
+*       None
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*
+* The edges recorded so far stay in the buffer until the next Capture_Start().
+*
+********************************************************************/
+void
+Capture_Stop( void )
+{
+    bCapturing = false;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Capture_IsRunning()
+*
+* DESCRIPTION
+*       Find out if edges are being recorded
+*
+* PARAMETERS
+*       None
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       bool            false once stopped or the buffer is full
+*
+* NOTES
+*
+********************************************************************/
+bool
+Capture_IsRunning( void )
+{
+    return bCapturing;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Capture_GetCount()
+*
+* DESCRIPTION
+*       Get the number of edges in the capture buffer
+*
+* PARAMETERS
+*       None
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       uint32_t        Edges recorded since Capture_Start()
+*
+* NOTES
+*
+********************************************************************/
+uint32_t
+Capture_GetCount( void )
+{
+    return CaptureEdges;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Capture_Rewind()
+*
+* DESCRIPTION
+*       Set a cursor to read the capture buffer from the first edge
+*
+* PARAMETERS
+*       sCaptureCursor*     pCursor     The cursor
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*
+********************************************************************/
+void
+Capture_Rewind( sCaptureCursor* pCursor )
+{
+    pCursor->Index = 0;
+    pCursor->Time  = 0;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Capture_NextEdge()
+*
+* DESCRIPTION
+*       Read the next edge from the capture buffer
+*
+* PARAMETERS
+*       sCaptureCursor*     pCursor     From Capture_Rewind()
+*
+* OUTPUTS
+*       uint32_t*           pTime       ms from Capture_Start() to the edge
+*       uint32_t*           pLevel      Radio data pin level after the edge, 0 or 1
+*
+* RETURNS
+*       bool                false if there are no more edges
+*
+* NOTES
+*
+* Can be called while a capture is running, it'll return false when it's
+* caught up with the ISR and carry on from there when more edges arrive.
+* The output is the msf-replay trace format.
+*
+********************************************************************/
+bool
+Capture_NextEdge( sCaptureCursor* pCursor, uint32_t* pTime, uint32_t* pLevel )
+{
+    uint32_t nEntries = CaptureEntries;
+    uint16_t entry;
+
+    while (pCursor->Index < nEntries)
+    {
+        entry = CaptureBuffer[ pCursor->Index++ ];
+
+        pCursor->Time += entry & CAPTURE_DELTA_MASK;
+
+        if ((entry & CAPTURE_DELTA_MASK) != CAPTURE_DELTA_ESCAPE)
+        {
+            *pTime  = pCursor->Time;
+            *pLevel = (entry & CAPTURE_LEVEL_BIT) ? 1 : 0;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Capture_Edge()
+*
+* DESCRIPTION
+*       Record an edge if a capture is running
+*
+* PARAMETERS
+*       uint32_t    level           Radio data pin level after the edge
+*       uint32_t    event_time      Tick count latched when the edge occurred
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*
+* Called by the radio ISR. Deltas are whole ms, the remainder is carried to
+* the next edge so the recorded times don't drift from the tick count, see
+* Capture_Idle() for gaps longer than the tick count wraps in.
+*
+********************************************************************/
+void
+Capture_Edge( uint32_t level, uint32_t event_time )
+{
+    uint32_t ms, n;
+
+    if (!bCapturing)
+        return;
+
+    ms = (event_time - T_CaptureLast) / CaptureTicksPerMs;
+    T_CaptureLast += ms * CaptureTicksPerMs;
+
+    n = CaptureEntries;
+
+    for ( ; (ms >= CAPTURE_DELTA_ESCAPE) && (n < MSF_CAPTURE_EDGES) ; ms -= CAPTURE_DELTA_ESCAPE)
+        CaptureBuffer[ n++ ] = CAPTURE_DELTA_ESCAPE;
+
+    if (n < MSF_CAPTURE_EDGES)
+    {
+        CaptureBuffer[ n++ ] = (uint16_t) (((level) ? CAPTURE_LEVEL_BIT : 0) | ms);
+        CaptureEdges++;
+    }
+
+    // Stop when full, a partly recorded edge would be lost anyway
+    if (n >= MSF_CAPTURE_EDGES)
+        bCapturing = false;
+
+    CaptureEntries = n;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Capture_Idle()
+*
+* DESCRIPTION
+*       Record the time passing with no edges, if a capture is running
+*
+* PARAMETERS
+*       uint32_t    now             The current tick count
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*
+* Called by the radio ISR at least every 2^32 ticks less 32767 ms. With the
+* capture timer the tick count wraps every 2^32 system clocks (35 seconds at
+* 120 MHz), so a longer gap between edges would be recorded short. This
+* records an escape entry for each 32767 ms of it as it goes.
+*
+********************************************************************/
+void
+Capture_Idle( uint32_t now )
+{
+    uint32_t n;
+
+    if (!bCapturing)
+        return;
+
+    n = CaptureEntries;
+
+    for ( ; (((now - T_CaptureLast) / CaptureTicksPerMs) >= CAPTURE_DELTA_ESCAPE) && (n < MSF_CAPTURE_EDGES) ; n++)
+    {
+        CaptureBuffer[ n ] = CAPTURE_DELTA_ESCAPE;
+        T_CaptureLast += CAPTURE_DELTA_ESCAPE * CaptureTicksPerMs;
+    }
+
+    if (n >= MSF_CAPTURE_EDGES)
+        bCapturing = false;
+
+    CaptureEntries = n;
+}
+
+#endif  // MSF_CAPTURE_EDGES
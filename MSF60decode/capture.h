@@ -0,0 +1,57 @@
+/********************************************************************************
+ * @file    capture.h
+ * @author  Tony Hanratty
+ * @date    14-Oct-2026
+ *
+ * @brief   Records the raw radio edges for replay on a PC
+ *
+ * @notes   Enabled by MSF_CAPTURE_EDGES in config.h. Each edge is stored as a
+ *          16 bit entry: the pin level in the top bit and the ms since the last
+ *          edge below it. Read the edges back with Capture_NextEdge() and write
+ *          them out as "<ms> <level>" lines for msf-replay.
+ ********************************************************************************/
+
+#ifndef _CAPTURE_H_
+#define _CAPTURE_H_
+
+
+// System includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// Our includes
+#include "config.h"
+
+
+
+#if (MSF_CAPTURE_EDGES > 0)
+
+/**
+ * Position in the capture buffer when reading it back. Time is the ms since
+ * Capture_Start() of the last edge read.
+ */
+typedef struct
+{
+    uint32_t    Index;
+    uint32_t    Time;
+} sCaptureCursor;
+
+
+
+// Thread
+void Capture_Start( void );
+void Capture_Stop( void );
+bool Capture_IsRunning( void );
+uint32_t Capture_GetCount( void );
+void Capture_Rewind( sCaptureCursor* pCursor );
+bool Capture_NextEdge( sCaptureCursor* pCursor, uint32_t* pTime, uint32_t* pLevel );
+
+// Radio ISR
+void Capture_Edge( uint32_t level, uint32_t event_time );
+void Capture_Idle( uint32_t now );
+
+#endif
+
+
+
+#endif  // _CAPTURE_H_
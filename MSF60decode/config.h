@@ -26,11 +26,329 @@
 
 
 
+/**
+ * Build profile. MSF_PROFILE_FULL leaves every option below at its default. MSF_PROFILE_MINIMAL
+ * is for small parts, e.g. a Cortex-M0 with 16 KB of flash. It builds one receiver with the
+ * hard engine, as the defaults do, and also turns off the LED, the debug UART, the signal
+ * quality, the pulse width calibration, polarity detection and drift measurement. Events are
+ * delivered straight from MSF_Process(), the edge queue is halved and the receiver state is
+ * packed. Vote history, edge capture and the statistics are already off by default. Any option
+ * set on the command line overrides the profile. host-replay/msf-footprint.sh builds the
+ * decoder for the target and reports the flash & RAM of each option on top of the minimal profile.
+ */
+#define     MSF_PROFILE_FULL                0
+#define     MSF_PROFILE_MINIMAL             1
+
+#if !defined(MSF_PROFILE)
+#define     MSF_PROFILE                     MSF_PROFILE_FULL
+#endif
+
+#if (MSF_PROFILE == MSF_PROFILE_MINIMAL)
+#if !defined(HW_ENABLE_LED)
+#define     HW_ENABLE_LED                   0
+#endif
+#if !defined(HW_ENABLE_DEBUG_UART)
+#define     HW_ENABLE_DEBUG_UART            0
+#endif
+#if !defined(MSF_EDGE_QUEUE_SIZE)
+#define     MSF_EDGE_QUEUE_SIZE             8
+#endif
+#if !defined(MSF_EVENT_QUEUE_SIZE)
+#define     MSF_EVENT_QUEUE_SIZE            0
+#endif
+#if !defined(MSF_ENABLE_QUALITY)
+#define     MSF_ENABLE_QUALITY              0
+#endif
+#if !defined(MSF_ADAPTIVE_MARGINS)
+#define     MSF_ADAPTIVE_MARGINS            0
+#endif
+#if !defined(MSF_DETECT_POLARITY)
+#define     MSF_DETECT_POLARITY             0
+#endif
+#if !defined(MSF_MEASURE_DRIFT)
+#define     MSF_MEASURE_DRIFT               0
+#endif
+#if !defined(MSF_PACKED_STATE)
+#define     MSF_PACKED_STATE                1
+#endif
+#endif  // MSF_PROFILE_MINIMAL
+
+
+
 /**
  * Hardware configuration options.
  */
+#if !defined(HW_ENABLE_LED)
 #define     HW_ENABLE_LED                   1                   // 0 to disable LED flash when MSF carrier signal toggles
+#endif
+#if !defined(HW_ENABLE_DEBUG_UART)
 #define     HW_ENABLE_DEBUG_UART            1                   // 0 to disable logging
+#endif
+#define     HW_ENABLE_CAPTURE_TIMER         0                   // 1 to timestamp radio edges with a GPTM instead of g_msSysTick
+#define     HW_ENABLE_UART_DMA              0                   // 1 to drain the debug & console UART buffers with the uDMA controller
+#define     HW_STATIC_VECTORS               0                   // 1 if the ISRs are named in the flash vector table, see below
+
+
+
+/**
+ * Interrupt priorities, as IntPrioritySet() takes them. The TM4C1294 has 8 levels in the top
+ * 3 bits, 0x00 is the most urgent and 0xE0 the least. The radio ISR only timestamps & queues
+ * each edge so it can run above a time critical control loop without disturbing it, and the
+ * edges are decoded at whatever priority calls MSF_Process(), see MSF_EDGE_QUEUED_HOOK().
+ * With g_msSysTick timestamps the SysTick must be at least as urgent as the radio ISR or the
+ * edges are timestamped late. Radio_IntDisable() only masks RADIO_INT_PRIORITY and below with
+ * BASEPRI, so RADIO_INT_PRIORITY can't be 0x00.
+ */
+#define     RADIO_INT_PRIORITY              0x20
+#define     SYSTICK_INT_PRIORITY            0x20
+#define     DEBUG_UART_INT_PRIORITY         0xE0
+
+
+
+/**
+ * Static vectors. By default the drivers install their ISRs with IntRegister() and friends,
+ * which the first time copies the vector table to the .vtable section in SRAM and points the
+ * NVIC at the copy. With HW_STATIC_VECTORS 1 they leave the vector table alone and the ISRs
+ * must be in the flash vector table of the startup file: RadioGpioIntHandler() on RADIO_INT_GPIO
+ * or RadioCaptureIntHandler() on RADIO_TIMER_INT, DebugUARTIntHandler() on DEBUG_UART_INT in a
+ * Debug build, and the client's SysTick handler. decoder-test/tm4c1294ncpdt_startup_ccs.c has
+ * them for this configuration, and complains if they're moved.
+ */
+
+
+
+/**
+ * Decoder software options.
+ *
+ * The radio ISR only timestamps each carrier edge and queues it. The edges are
+ * decoded later in thread context by MSF_Process(). The queue size must be a
+ * power of 2. An MSF frame has at most 4 edges per second so 16 entries gives
+ * the application several seconds of slack between calls to MSF_Process().
+ */
+#if !defined(MSF_EDGE_QUEUE_SIZE)
+#define     MSF_EDGE_QUEUE_SIZE             16
+#endif
+
+/**
+ * MSF_EDGE_QUEUED_HOOK() is called by the radio ISR after each edge is queued. By default the
+ * client's main loop calls MSF_Process(), but the hook can instead call a client function that
+ * pends a spare low priority interrupt with IntPendSet(), whose handler calls MSF_Process(). The
+ * edges are then captured above the application's time critical interrupts and decoded below them.
+ */
+#define     MSF_EDGE_QUEUED_HOOK()
+
+
+
+/**
+ * Client event queue. MSF_Process() queues the client's event notifications and the client
+ * delivers them in a batch with MSF_DispatchEvents(), so a slow event handler can't hold up
+ * decoding. MSF_EVENT_QUEUED_HOOK() is called after each event is queued, e.g. to signal the
+ * RTOS task that calls MSF_DispatchEvents(). The queue size must be a power of 2. Events are
+ * coalesced as they're delivered: a repeated event is delivered once, and a SYNC_LOST followed
+ * by a SYNC within MSF_EVENT_COALESCE_MS is dropped, the SYNC_LOST being held back that long.
+ * 0 calls the event handler straight from MSF_Process() instead.
+ */
+#if !defined(MSF_EVENT_QUEUE_SIZE)
+#define     MSF_EVENT_QUEUE_SIZE            8
+#endif
+
+#define     MSF_EVENT_COALESCE_MS           1000
+#define     MSF_EVENT_QUEUED_HOOK()
+
+
+
+/**
+ * Select the decoder engine.
+ *
+ * MSF_ENGINE_HARD  Classifies every edge as it arrives. Any out of margin timing loses that cell,
+ *                  which is filled in from the parity bits if possible. The decoder only reSYNCs
+ *                  if the 1 Hz second markers are lost. Small and fast.
+ *
+ * MSF_ENGINE_SOFT  Records the edges in each second and picks the most likely A/B bit pair by how
+ *                  much of each 100ms slot the carrier was OFF, keeping a confidence for every bit.
+ *                  It flywheels on the 1 Hz second markers through noise and corrects single bit
+ *                  errors with the parity bits instead of reSYNCing. Better for weak signals.
+ */
+#define     MSF_ENGINE_HARD                 0
+#define     MSF_ENGINE_SOFT                 1
+
+#if !defined(MSF_DECODER_ENGINE)
+#define     MSF_DECODER_ENGINE              MSF_ENGINE_HARD
+#endif
+
+
+
+/**
+ * Multi-frame voting. If a frame fails validation or lost cells that parity can't fill in,
+ * the frames received in the last MSF_VOTE_FRAMES minutes are advanced to the current minute
+ * and a majority vote taken on every bit by the frames that received it. If the voted frame
+ * passes validation it's decoded instead. The minutes are counted from the second markers,
+ * so frames either side of a reSYNC are voted together. Each frame of history costs 32 bytes
+ * of RAM. An odd number like 5 works best, 0 disables voting.
+ */
+#if !defined(MSF_VOTE_FRAMES)
+#define     MSF_VOTE_FRAMES                 0
+#endif
+
+
+
+/**
+ * Frame plausibility. Every frame that passes the parity checks has its date/time range checked,
+ * then it's compared with the minute predicted by the free running clock, set from the frames
+ * accepted before, or with the last frame if that wasn't predicted. sMSFDateTime.FrameCheck says
+ * which. With 1 a frame that contradicts the clock is only accepted once the next frame confirms
+ * it. One with nothing to predict it, like the first after reset, is accepted straight away as
+ * MSF_FRAME_UNCONFIRMED, so a client can wait for a confirmed frame if it needs to. 0 accepts
+ * every frame that passes the range checks.
+ */
+#if !defined(MSF_FRAME_PREDICTION)
+#define     MSF_FRAME_PREDICTION            1
+#endif
+
+
+
+/**
+ * Decoder instrumentation. Counts the edges, pulse widths, loss of SYNC reasons and frames
+ * decoded, and times the radio ISR, the decoder engine, the frame decode and the client
+ * callbacks with the DWT cycle counter. Read them with MSF_GetStats(). Each timed section
+ * adds a few cycles, so leave it disabled in release builds. It can also be set on the command
+ * line, e.g. -DMSF_ENABLE_STATS=1 for the host replay tool.
+ */
+#if !defined(MSF_ENABLE_STATS)
+#define     MSF_ENABLE_STATS                0
+#endif
+
+
+
+/**
+ * Signal quality measurements, read with MSF_GetSignalQuality(). Each receiver keeps running
+ * averages of the edge timing error and the edges in margin, a histogram of the edge errors,
+ * a bit error rate estimated from the parity checks and a 0-100 lock quality, which picks the
+ * receiver to follow when there's more than one. A few adds and shifts per edge and about 50
+ * bytes of RAM per receiver. 0 disables them.
+ */
+#if !defined(MSF_ENABLE_QUALITY)
+#define     MSF_ENABLE_QUALITY              1
+#endif
+
+
+
+/**
+ * Pulse width calibration. Many receivers report CARRIER_ON edges later than CARRIER_OFF edges,
+ * or the other way round, so every pulse is a little long or short. Each frame that passes
+ * validation moves a learned CARRIER_ON edge delay towards the one it measured, and every width
+ * is corrected by it before it's classified. After a few good frames the hard engine also
+ * narrows the accepted margin to a few times the measured spread of the widths, to reject more
+ * noise edges. The soft engine only uses the delay. 0 uses the fixed PULSE_MARGIN, as before
+ * it was added, so turning it on changes how an existing receiver's pulses are classified.
+ */
+#if !defined(MSF_ADAPTIVE_MARGINS)
+#define     MSF_ADAPTIVE_MARGINS            0
+#endif
+
+
+
+/**
+ * Receiver output polarity detection. The decoder expects the data pin high when the carrier
+ * is OFF, but some receivers have the opposite output. Every second carries a long CARRIER_ON
+ * pulse & never a long CARRIER_OFF one, so if the long pulses keep coming out the other way up
+ * the edge levels from that receiver are inverted from then on. It takes about 8 seconds to
+ * notice. 0 trusts the pin levels, as before it was added.
+ */
+#if !defined(MSF_DETECT_POLARITY)
+#define     MSF_DETECT_POLARITY             0
+#endif
+
+
+
+/**
+ * Local oscillator drift measurement, see MSF_GetClockDrift(). A least squares fit of the second
+ * markers over each 15 minute block, which the clock corrects for in holdover. It needs 64 bit
+ * multiplies & divides, a few hundred bytes of library code on a Cortex-M0, and about 50 bytes
+ * of RAM per receiver. 0 leaves the clock uncorrected in holdover.
+ */
+#if !defined(MSF_MEASURE_DRIFT)
+#define     MSF_MEASURE_DRIFT               1
+#endif
+
+
+
+/**
+ * Packed receiver state. The decoder state flags take a bit each and its small counters and
+ * enums a byte. It only saves about 16 bytes of RAM per receiver, most of the state is tick
+ * counts and frame words, and the bit-field accesses cost 50 to 100 bytes of flash. Worth it
+ * with several receivers on a part short of RAM. 0 keeps them all as bool and unsigned, which
+ * is smaller and quicker on most parts.
+ */
+#if !defined(MSF_PACKED_STATE)
+#define     MSF_PACKED_STATE                0
+#endif
+
+
+
+/**
+ * Glitch filter ahead of the decoder engine. A CARRIER_ON or CARRIER_OFF pulse shorter than
+ * MSF_GLITCH_FILTER_MS is a spike from the receiver and the edges at both ends of it are dropped.
+ * An edge that leaves the carrier level unchanged, e.g. a spike too short for the ISR to read
+ * the pin before it ended, is merged into the edge before. Each edge is held by MSF_Process()
+ * till the next edge arrives or MSF_GLITCH_FILTER_MS has passed. The shortest MSF pulse is
+ * 100 ms, so anything up to about 20 ms loses no real edges. 0 disables the filter.
+ */
+#if !defined(MSF_GLITCH_FILTER_MS)
+#define     MSF_GLITCH_FILTER_MS            15
+#endif
+
+
+
+/**
+ * Raw edge capture. The radio ISR records the level and time of every edge into an SRAM
+ * buffer of MSF_CAPTURE_EDGES 16 bit entries while a capture is running, see capture.h.
+ * A clean signal averages just over 2 edges a second, so 16384 entries (32 KB) holds about
+ * 2 hours. Gaps of over 32.767 seconds take an extra entry for every 32.767 seconds.
+ * 0 disables capture.
+ */
+#if !defined(MSF_CAPTURE_EDGES)
+#define     MSF_CAPTURE_EDGES               0
+#endif
+
+
+
+/**
+ * Number of MSF receivers decoded at once. Each has its own data pin on RADIO_PORT_BASE,
+ * listed in RADIO_DATA_PINS, and its own decoder state, about 350 bytes of RAM for the hard
+ * engine and 500 for the soft. The client gets the time from whichever receiver decodes a
+ * frame first, see MSF_GetLeadReceiver(). More than one receiver needs HW_ENABLE_CAPTURE_TIMER 0.
+ * They must all be MSF receivers, there's no DCF77 or WWVB decoder.
+ */
+#if !defined(MSF_NUM_RECEIVERS)
+#define     MSF_NUM_RECEIVERS               1
+#endif
+
+
+
+/**
+ * Pulse width classification margins in milliseconds. A pulse is accepted as a nominal
+ * width if it's within +/- the margin. By default every band is +/- PULSE_MARGIN but each
+ * can be set separately for CARRIER_OFF pulses, CARRIER_ON pulses and the offset of a
+ * CARRIER_ON edge from the start of the cell. Bands must not overlap.
+ */
+#define     PULSE_MARGIN                    30
+
+#define     OFF_MARGIN_100                  PULSE_MARGIN
+#define     OFF_MARGIN_200                  PULSE_MARGIN
+#define     OFF_MARGIN_300                  PULSE_MARGIN
+#define     OFF_MARGIN_500                  PULSE_MARGIN
+
+#define     ON_MARGIN_100                   PULSE_MARGIN
+#define     ON_MARGIN_500                   PULSE_MARGIN
+#define     ON_MARGIN_700                   PULSE_MARGIN
+#define     ON_MARGIN_800                   PULSE_MARGIN
+#define     ON_MARGIN_900                   PULSE_MARGIN
+
+#define     OFFSET_MARGIN_100               PULSE_MARGIN
+#define     OFFSET_MARGIN_200               PULSE_MARGIN
+#define     OFFSET_MARGIN_300               PULSE_MARGIN
+#define     OFFSET_MARGIN_500               PULSE_MARGIN
 
 
 
@@ -43,6 +361,28 @@
 #define     RADIO_DATA_BIT                  GPIO_PIN_3
 #define     RADIO_INT_GPIO                  INT_GPIOB
 
+// Data pin of each receiver, MSF_NUM_RECEIVERS of them. RADIO_ENABLE_BIT is shared.
+#if !defined(RADIO_DATA_PINS)
+#define     RADIO_DATA_PINS                 { RADIO_DATA_BIT }
+#endif
+
+
+
+/**
+ * (optional) GPTM used in edge-time capture mode to timestamp the radio edges in hardware.
+ * The timer runs from the system clock and must be the CCP function of RADIO_DATA_BIT,
+ * PB3 is T5CCP1 so it's Timer 5B here. The client doesn't need to provide g_msSysTick.
+ */
+#define     RADIO_TIMER_SYSCTL_PERIPH       SYSCTL_PERIPH_TIMER5
+#define     RADIO_TIMER_BASE                TIMER5_BASE
+#define     RADIO_TIMER                     TIMER_B
+#define     RADIO_TIMER_CONFIG              (TIMER_CFG_SPLIT_PAIR | TIMER_CFG_B_CAP_TIME_UP)
+#define     RADIO_TIMER_CAPTURE_EVENT       TIMER_CAPB_EVENT
+#define     RADIO_TIMER_TIMEOUT_EVENT       TIMER_TIMB_TIMEOUT
+#define     RADIO_TIMER_INT                 INT_TIMER5B
+#define     RADIO_TIMER_VALUE_REG           TIMER_O_TBV
+#define     RADIO_DATA_PIN_CONFIG           GPIO_PB3_T5CCP1
+
 
 
 /**
@@ -58,6 +398,28 @@
 #define     DEBUG_UART_TX_PIN_CONFIG        GPIO_PP1_U6TX
 #define     DEBUG_UART_RX_PIN               GPIO_PIN_0
 #define     DEBUG_UART_TX_PIN               GPIO_PIN_1
+#define     DEBUG_UART_DMA_CHANNEL          UDMA_CH11_UART6TX   // If HW_ENABLE_UART_DMA is 1
+
+
+
+/**
+ * Size of the debug UART transmit buffer, which must be a power of 2, and what
+ * Debug_write() does when it's full. Debug_GetStats() reports how full it has got
+ * and how much was lost, so the buffer can be sized from real data.
+ *
+ * DEBUG_DROP_NEWEST    Discard whatever doesn't fit.
+ * DEBUG_DROP_OLDEST    Discard the oldest characters still waiting to be sent to make room.
+ *                      Not available with HW_ENABLE_UART_DMA.
+ * DEBUG_BLOCK          Wait for space. Only in thread context with interrupts enabled,
+ *                      otherwise it's the same as DEBUG_DROP_NEWEST. Note a blocked
+ *                      LOG_Flush() holds up MSF_Process().
+ */
+#define     DEBUG_DROP_NEWEST               0
+#define     DEBUG_DROP_OLDEST               1
+#define     DEBUG_BLOCK                     2
+
+#define     DEBUG_UART_TX_BUFFER_SIZE       1024
+#define     DEBUG_UART_OVERFLOW_POLICY      DEBUG_DROP_NEWEST
 
 
 
@@ -20,14 +20,20 @@
 // TI platform
 #include "inc/hw_ints.h"
 #include "inc/hw_memmap.h"
+#include "inc/hw_nvic.h"
+#include "inc/hw_types.h"
+#include "driverlib/cpu.h"
 #include "driverlib/gpio.h"
 #include "driverlib/interrupt.h"
 #include "driverlib/pin_map.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/uart.h"
+#include "driverlib/udma.h"
 
 // Our includes
 #include "config.h"
+#include "ringbuf.h"
+#include "uartdma.h"
 
 // This file's include
 #include "hardware.h"
@@ -41,20 +47,13 @@
 #if (HW_ENABLE_DEBUG_UART==1) && defined(DEBUG)
 
 
-#define     DEBUG_UART_TX_BUFFER_SIZE   1024
+#if !RING_SIZE_OK(DEBUG_UART_TX_BUFFER_SIZE)
+#error "DEBUG_UART_TX_BUFFER_SIZE must be a power of 2"
+#endif
 
-
-
-
-
-//*****************************************************************************
-// Transmit Buffer Macros
-//*****************************************************************************
-
-#define TX_BUFFER_EMPTY()                   (Debug_TxBufferCount()==0)
-#define TX_BUFFER_FULL()                    (Debug_TxBufferCount()==DEBUG_UART_TX_BUFFER_SIZE)
-
-#define ADVANCE_TX_BUFFER_INDEX(Index)      do {(Index) = ((Index) + 1) % DEBUG_UART_TX_BUFFER_SIZE;} while(0)
+#if (DEBUG_UART_OVERFLOW_POLICY == DEBUG_DROP_OLDEST) && (HW_ENABLE_UART_DMA == 1)
+#error "DEBUG_DROP_OLDEST can't discard characters already handed to the uDMA"
+#endif
 
 
 
@@ -69,12 +68,35 @@ STATIC const char* pcHexChars = "0123456789abcdef";
 
 
 /**
- * Output ring buffer. Buffer is full if TxReadIndex is one ahead of
- * TxWriteIndex. Buffer is empty if the two indices are the same.
+ * Output ring buffer. Debug_write() is the only producer and the UART ISR the
+ * only consumer, so Debug_write() must not be called from an interrupt handler
+ * that could preempt another call to it.
  */
 STATIC uint8_t TxBuffer[ DEBUG_UART_TX_BUFFER_SIZE ];
-STATIC volatile uint32_t TxWriteIndex = 0;
-STATIC volatile uint32_t TxReadIndex = 0;
+STATIC sRingBuffer TxRing = RING_BUFFER_INIT( TxBuffer );
+
+/**
+ * Set by the UART ISR when it has nothing left to send, so Debug_write() needs
+ * to pend the interrupt to get it going again
+ */
+STATIC volatile bool bTxIdle = true;
+
+// Transmit buffer usage, for Debug_GetStats()
+STATIC sDebugStats DebugStats = { DEBUG_UART_TX_BUFFER_SIZE, 0, 0, 0, 0 };
+
+
+#if (HW_ENABLE_UART_DMA == 1)
+/**
+ * The uDMA channel that drains TxRing
+ */
+STATIC sUartDmaTx DebugDmaTx = {
+    DEBUG_UART_BASE,
+    DEBUG_UART_DMA_CHANNEL,
+    &TxRing,
+    { 0, 0 },
+    UDMA_PRI_SELECT
+};
+#endif
 
 
 
@@ -111,10 +133,14 @@ void
 Debug_FlushTxBuffer( void )
 {
     // The remaining data should be discarded, so temporarily turn off interrupts.
+    // Emptying the ring is the consumer's job so the UART ISR must be kept out.
     bool MasterintStatus = IntMasterDisable();
 
-    // Flush the buffer indices
-    TxReadIndex = TxWriteIndex = 0;
+#if (HW_ENABLE_UART_DMA == 1)
+    UartDma_FlushTx(&DebugDmaTx);
+#else
+    Ring_Flush(&TxRing);
+#endif
 
     // If interrupts were enabled when we turned them off, turn them back on again.
     if(!MasterintStatus)
@@ -145,55 +171,68 @@ Debug_FlushTxBuffer( void )
 uint32_t
 Debug_TxBufferCount( void )
 {
-    uint32_t ui32Write = TxWriteIndex;
-    uint32_t ui32Read  = TxReadIndex;
-
-    return (ui32Write >= ui32Read)
-           ? (ui32Write - ui32Read)
-           : (DEBUG_UART_TX_BUFFER_SIZE - (ui32Read - ui32Write));
+    return Ring_Count(&TxRing);
 }
 
 
 
+#if (HW_ENABLE_UART_DMA == 1)
+
+/*****************************************************************************\
+ *
+ * UART uDMA TX interrupt handler. Called at the end of each uDMA transfer, or
+ * when Debug_write() pends the interrupt to start transmitting.
+ *
+\*****************************************************************************/
+void
+DebugUARTIntHandler(void)
+{
+    uint32_t int_status;
+
+    // Get and clear the current interrupt source(s)
+    int_status = UARTIntStatus(DEBUG_UART_BASE, true);
+    UARTIntClear(DEBUG_UART_BASE, int_status);
 
+    // Free the space used by any completed transfer and start on the rest of the buffer.
+    // Once nothing is in flight there won't be another UART_INT_DMATX.
+    bTxIdle = !UartDma_ServiceTx(&DebugDmaTx);
+}
 
+#else
 
 /*****************************************************************************\
  *
  * Take as many bytes from the transmit buffer as we have space for and move
  * them into the UART transmit FIFO.
  *
- * Returns # bytes written to the TX FIFO
- *
 \*****************************************************************************/
 STATIC void
 PrimeTheTransmitFIFO( void )
 {
-    // Do we have any data to transmit?
-    if(!TX_BUFFER_EMPTY())
+    const uint8_t* pData;
+    uint32_t ui32Len, ui32Sent;
+
+    // The data may be in two parts if the ring has wrapped
+    do
     {
-        // Disable the UART interrupt while we're playing with the buffer indexes
-        IntDisable(DEBUG_UART_INT);
+        ui32Len = Ring_ReadSpan(&TxRing, 0, &pData);
 
-        // Yes. Take some characters out of the transmit buffer and feed them to the UART transmit FIFO.
-        while(UARTSpaceAvail(DEBUG_UART_BASE) && !TX_BUFFER_EMPTY())
-        {
-            UARTCharPutNonBlocking(DEBUG_UART_BASE, TxBuffer[ TxReadIndex ]);
-            ADVANCE_TX_BUFFER_INDEX( TxReadIndex );
-        }
+        for(ui32Sent = 0 ; (ui32Sent < ui32Len) && UARTCharPutNonBlocking(DEBUG_UART_BASE, pData[ ui32Sent ]) ; ui32Sent++);
 
-        IntEnable(DEBUG_UART_INT);
+        Ring_Consume(&TxRing, ui32Sent);
     }
+    while(ui32Sent && (ui32Sent == ui32Len));
 }
 
 
 
 /*****************************************************************************\
  *
- * UART TX interrupt handler
+ * UART TX interrupt handler. Called when the TX FIFO is almost empty, or when
+ * Debug_write() pends the interrupt to start transmitting.
  *
 \*****************************************************************************/
-STATIC void
+void
 DebugUARTIntHandler(void)
 {
     uint32_t int_status;
@@ -202,23 +241,24 @@ DebugUARTIntHandler(void)
     int_status = UARTIntStatus(DEBUG_UART_BASE, true);
     UARTIntClear(DEBUG_UART_BASE, int_status);
 
-    // TX FIFO has space available
-    if(int_status & UART_INT_TX)
+    // Write as many bytes as we can into the transmit FIFO.
+    PrimeTheTransmitFIFO();
+
+    // If the output buffer is now empty, turn off the transmit interrupt.
+    if(Ring_Count(&TxRing) == 0)
     {
-        // If the output buffer is now empty, turn off the transmit interrupt.
-        if(TX_BUFFER_EMPTY())
-        {
-            UARTIntDisable(DEBUG_UART_BASE, UART_INT_TX);
-        }
-        else
-        {
-            // Write as many bytes as we can into the transmit FIFO.
-            PrimeTheTransmitFIFO();
-            UARTIntEnable(DEBUG_UART_BASE, UART_INT_TX);
-        }
+        UARTIntDisable(DEBUG_UART_BASE, UART_INT_TX);
+        bTxIdle = true;
+    }
+    else
+    {
+        UARTIntEnable(DEBUG_UART_BASE, UART_INT_TX);
+        bTxIdle = false;
     }
 }
 
+#endif  // (HW_ENABLE_UART_DMA == 1)
+
 
 
 /*****************************************************************************\
@@ -259,21 +299,56 @@ Debug_InitUART( void )
     // Set the UART to interrupt whenever the TX FIFO is almost empty or when any character is received.
     UARTFIFOLevelSet(DEBUG_UART_BASE, UART_FIFO_TX1_8, UART_FIFO_RX1_8);
 
+#if (HW_ENABLE_UART_DMA == 1)
+    UartDma_InitTx(&DebugDmaTx);
+#endif
+
     Debug_FlushTxBuffer();
 
     // Don't enable the TX interrupt in the UART till data has been written to the TX FIFO
     UARTIntDisable(DEBUG_UART_BASE, 0xFFFFFFFF);
+#if (HW_STATIC_VECTORS == 0)
     IntRegister(DEBUG_UART_INT, DebugUARTIntHandler);
+#endif
+    IntPrioritySet(DEBUG_UART_INT, DEBUG_UART_INT_PRIORITY);
     IntEnable(DEBUG_UART_INT);
 
     // Enable the UART operation.
     UARTEnable(DEBUG_UART_BASE);
 
+#if (HW_ENABLE_UART_DMA == 1)
+    // The uDMA feeds the TX FIFO and interrupts once per transfer instead
+    UARTIntEnable(DEBUG_UART_BASE, UART_INT_DMATX);
+#endif
+
     return true;
 }
 
 
 
+#if (DEBUG_UART_OVERFLOW_POLICY == DEBUG_BLOCK)
+
+/**
+ * Can Debug_write() wait for the UART ISR to make space? Not if we're in an
+ * interrupt handler, interrupts are disabled or BASEPRI masks the UART ISR,
+ * e.g. in a Radio_IntDisable() critical section.
+ */
+STATIC bool
+DebugCanBlock( void )
+{
+    uint32_t mask = IntPriorityMaskGet();
+
+    // BASEPRI 0 masks nothing
+    if ((mask != 0) && (mask <= DEBUG_UART_INT_PRIORITY))
+        return false;
+
+    return !CPUprimask() && !(HWREG(NVIC_INT_CTRL) & NVIC_INT_CTRL_VEC_ACT_M);
+}
+
+#endif
+
+
+
 /*****************************************************************************\
  *
  * Writes a string of characters to the debug UART
@@ -285,51 +360,138 @@ Debug_InitUART( void )
  * characters to transmit is the ui32Len parameter.  This
  * function does no interpretation or translation of any characters.
  *
+ * If the transmit buffer is full DEBUG_UART_OVERFLOW_POLICY decides what's
+ * lost (see config.h). Every character dropped is counted in the stats.
+ *
  * Returns the number of characters written.
  *
 \*****************************************************************************/
 uint32_t
 Debug_write(const char *pBuffer, uint32_t len)
 {
-uint32_t nWriteCount = 0;
-uint32_t index;
+uint32_t nWriteCount;
+uint32_t nCount;
 
-    // Write as many characters as we can to the transmit buffer
-    for(index=0 ; index < len ; index++)
+#if (DEBUG_UART_OVERFLOW_POLICY == DEBUG_DROP_OLDEST)
+
+    // Only the end of a very long string can be kept
+    if(len > DEBUG_UART_TX_BUFFER_SIZE)
     {
-        if(!TX_BUFFER_FULL())
-        {
-            TxBuffer[ TxWriteIndex ] = pBuffer[ index ];
-            ADVANCE_TX_BUFFER_INDEX( TxWriteIndex );
-            nWriteCount++;
-        }
-        else
+        DebugStats.ui32Dropped += len - DEBUG_UART_TX_BUFFER_SIZE;
+        pBuffer += len - DEBUG_UART_TX_BUFFER_SIZE;
+        len = DEBUG_UART_TX_BUFFER_SIZE;
+    }
+
+    if(len > Ring_Space(&TxRing))
+    {
+        // Make room by discarding the oldest characters. That's the consumer's job, so keep the UART ISR out.
+        IntDisable(DEBUG_UART_INT);
+
+        if(len > Ring_Space(&TxRing))
         {
-            // Buffer is full - ignore remaining characters and return.
-            break;
+            nCount = len - Ring_Space(&TxRing);
+            Ring_Consume(&TxRing, nCount);
+            DebugStats.ui32Dropped += nCount;
         }
+
+        IntEnable(DEBUG_UART_INT);
     }
 
+    nWriteCount = Ring_Write(&TxRing, pBuffer, len);
+
+#elif (DEBUG_UART_OVERFLOW_POLICY == DEBUG_BLOCK)
+
+    nWriteCount = Ring_Write(&TxRing, pBuffer, len);
 
-    // If there's anything in the transmit buffer, ensure UART TX interrupts are enabled.
-    if(!TX_BUFFER_EMPTY())
+    // Wait for the UART ISR to send enough to fit in the rest
+    if((nWriteCount < len) && DebugCanBlock())
     {
-        PrimeTheTransmitFIFO();
-        UARTIntEnable(DEBUG_UART_BASE, UART_INT_TX);
+        DebugStats.ui32Blocked++;
+
+        do
+        {
+            if(bTxIdle)
+                IntPendSet(DEBUG_UART_INT);
+
+            nWriteCount += Ring_Write(&TxRing, pBuffer + nWriteCount, len - nWriteCount);
+        }
+        while(nWriteCount < len);
     }
 
+#else
+
+    // Write as many characters as we can to the transmit buffer. Any others are dropped.
+    nWriteCount = Ring_Write(&TxRing, pBuffer, len);
+
+#endif
+
+    DebugStats.ui32Written += nWriteCount;
+    DebugStats.ui32Dropped += len - nWriteCount;
+
+    nCount = Ring_Count(&TxRing);
+    if(nCount > DebugStats.ui32HighWater)
+        DebugStats.ui32HighWater = nCount;
+
+    // Have the UART ISR start transmitting, if it's stopped
+    if(nWriteCount && bTxIdle)
+        IntPendSet(DEBUG_UART_INT);
+
     // Return the number of characters written.
     return nWriteCount;
 }
 
 
 
+/*******************************************************************
+* NAME
+*       Debug_GetStats()
+*
+* DESCRIPTION
+*       Get the debug UART transmit buffer statistics
+*
+* PARAMETERS
+*       pStats      Where to put them
+*
+* OUTPUTS
+*       *pStats     Buffer size, high water mark and character counts since
+*                   the debug UART was initialised
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*       If ui32HighWater reaches ui32BufferSize or ui32Dropped isn't 0 the
+*       buffer is too small for the logging enabled.
+*
+********************************************************************/
+void
+Debug_GetStats( sDebugStats* pStats )
+{
+    *pStats = DebugStats;
+}
+
+
+
+// Write part of the formatter's output, counting anything the buffer couldn't take
+#define FORMAT_WRITE(buf, len)  do { uint32_t n_ = (len); nDropped += n_ - Debug_write((buf), n_); } while(0)
+
+
+// Fetch the next argument for the formatter, from the raw argument array if there is one
+#define NEXT_ARG(type)      ((puiArgs) ? (type)((nArgs) ? (nArgs--, *puiArgs++) : 0) : va_arg(*pvaArgP, type))
+
+
+
 //*****************************************************************************
 //
 // A simple vprintf function supporting \%c, \%d, \%p, \%s, \%u, \%x, and \%X.
 //
 // \param pcString is the format string.
-// \param vaArgP is a vararg list pointer
+// \param pvaArgP is a vararg list pointer
+// \param puiArgs is an array of nArgs raw arguments, 32 bit values or string
+// pointers, used instead of pvaArgP if it's not NULL. Missing arguments are
+// taken as 0.
+//
+// Returns the number of characters dropped because the transmit buffer was full.
 //
 // Only the following formatting characters are supported:
 //
@@ -351,11 +513,12 @@ uint32_t index;
 // add zeroes instead of spaces.
 //
 //*****************************************************************************
-void
-Debug_vprintf(const char *pcString, va_list vaArgP)
+STATIC uint32_t
+DebugFormat(const char *pcString, va_list* pvaArgP, const uintptr_t* puiArgs, uint32_t nArgs)
 {
     uint32_t ui32Idx, ui32Value, ui32Pos, ui32Count, ui32Base, ui32Neg;
     char *pcStr, pcBuf[16], cFill;
+    uint32_t nDropped = 0;
 
 
     // Loop while there are more characters in the string.
@@ -368,7 +531,7 @@ Debug_vprintf(const char *pcString, va_list vaArgP)
 
 
         // Write this portion of the string.
-        Debug_write(pcString, ui32Idx);
+        FORMAT_WRITE(pcString, ui32Idx);
 
         // Skip the portion of the string that was written.
         pcString += ui32Idx;
@@ -420,8 +583,8 @@ again:
                 // Handle the %c command.
                 case 'c':
                     // Get the CHAR from the varargs AND PRINT IT
-                    ui32Value = va_arg(vaArgP, uint32_t);
-                    Debug_write((char *) &ui32Value, 1);
+                    ui32Value = NEXT_ARG(uint32_t);
+                    FORMAT_WRITE((char *) &ui32Value, 1);
                     break;
 
 
@@ -430,7 +593,7 @@ again:
                 case 'i':
                 {
                     // Get the value from the varargs.
-                    ui32Value = va_arg(vaArgP, uint32_t);
+                    ui32Value = NEXT_ARG(uint32_t);
 
                     // Reset the buffer position.
                     ui32Pos = 0;
@@ -459,18 +622,18 @@ again:
                 case 's':
                 {
                     // Get the string pointer from the varargs.
-                    pcStr = va_arg(vaArgP, char *);
+                    pcStr = NEXT_ARG(char *);
 
                     // Determine the length of the string and write it out
                     for( ui32Idx = 0 ; pcStr[ui32Idx] != '\0' ; ui32Idx++ );
-                    Debug_write(pcStr, ui32Idx);
+                    FORMAT_WRITE(pcStr, ui32Idx);
 
                     // Write any required padding spaces
                     if(ui32Count > ui32Idx)
                     {
                         ui32Count -= ui32Idx;
                         while(ui32Count--)
-                            Debug_write(" ", 1);
+                            FORMAT_WRITE(" ", 1);
                     }
                     break;
                 }
@@ -478,7 +641,7 @@ again:
 
                 // Handle the %u command.
                 case 'u':
-                    ui32Value = va_arg(vaArgP, uint32_t);                               // Get the value from the varargs.
+                    ui32Value = NEXT_ARG(uint32_t);                               // Get the value from the varargs.
                     ui32Pos  = 0;                                                       // Reset the buffer position.
                     ui32Base = 10;                                                      // Set the base to 10.
                     ui32Neg  = 0;                                                       // Indicate that the value is positive so that a minus sign isn't inserted.
@@ -491,7 +654,7 @@ again:
                 case 'X':
                 case 'p':
                 {
-                    ui32Value = va_arg(vaArgP, uint32_t);                               // Get the value from the varargs.
+                    ui32Value = NEXT_ARG(uint32_t);                               // Get the value from the varargs.
                     ui32Pos   = 0;                                                      // Reset the buffer position.
                     ui32Base  = 16;                                                     // Set the base to 16.
                     ui32Neg   = 0;                                                      // Indicate that the value is positive so that a minus sign isn't inserted.
@@ -532,7 +695,7 @@ convert:
                     }
 
                     // Write the string.
-                    Debug_write(pcBuf, ui32Pos);
+                    FORMAT_WRITE(pcBuf, ui32Pos);
 
                     break;
                 }
@@ -541,18 +704,64 @@ convert:
                 // Handle the %% command.
                 case '%':
                     // Simply write a single %.
-                    Debug_write("%", 1);
+                    FORMAT_WRITE("%", 1);
                     break;
 
 
                 // Handle all other formatting commands.
                 default:
                     // Indicate an error.
-                    Debug_write("ERROR", 5);
+                    FORMAT_WRITE("ERROR", 5);
                     break;
             }
         }
     }
+
+    return nDropped;
+}
+
+
+
+/*****************************************************************************\
+ *
+ * Format a string with a va_list of arguments to the debug UART
+ *
+ * Returns the number of characters dropped because the transmit buffer was full.
+ *
+\*****************************************************************************/
+uint32_t
+Debug_vprintf(const char *pcString, va_list vaArgP)
+{
+    va_list vaArgs;
+    uint32_t nDropped;
+
+    // The formatter takes a pointer so it can share the argument fetching with Debug_printArgs()
+#if defined(va_copy)
+    va_copy(vaArgs, vaArgP);
+    nDropped = DebugFormat(pcString, &vaArgs, NULL, 0);
+    va_end(vaArgs);
+#else
+    vaArgs = vaArgP;
+    nDropped = DebugFormat(pcString, &vaArgs, NULL, 0);
+#endif
+
+    return nDropped;
+}
+
+
+
+/*****************************************************************************\
+ *
+ * Format a string with arguments previously saved as raw 32 bit values or string
+ * pointers to the debug UART. Used to format deferred log records.
+ *
+ * Returns the number of characters dropped because the transmit buffer was full.
+ *
+\*****************************************************************************/
+uint32_t
+Debug_printArgs(const char *pcString, const uintptr_t* puiArgs, uint32_t nArgs)
+{
+    return DebugFormat(pcString, NULL, puiArgs, nArgs);
 }
 
 
@@ -586,19 +795,25 @@ convert:
 //! added to reach eight; "\%08d" will use eight characters as well but will
 //! add zeroes instead of spaces.
 //!
+//! Returns the number of characters dropped because the transmit buffer was
+//! full.
+//!
 //*****************************************************************************
-void
+uint32_t
 Debug_printf(const char *pcString, ...)
 {
     va_list vaArgP;
+    uint32_t nDropped;
 
     // Start varargs processing.
     va_start(vaArgP, pcString);
 
-    Debug_vprintf(pcString, vaArgP);
+    nDropped = Debug_vprintf(pcString, vaArgP);
 
     // Finished with the varargs. Tidy up.
     va_end(vaArgP);
+
+    return nDropped;
 }
 
 
@@ -14,7 +14,7 @@
 // System includes
 #include <stdint.h>
 #include <stdbool.h>
-#include <stdio.h>
+#include <stdarg.h>
 
 // Our includes
 #include "config.h"
@@ -23,13 +23,32 @@
 
 
 
+/**
+ * Debug UART transmit buffer statistics, see Debug_GetStats()
+ */
+typedef struct
+{
+    uint32_t    ui32BufferSize;         // DEBUG_UART_TX_BUFFER_SIZE
+    uint32_t    ui32HighWater;          // Most characters ever waiting to be sent
+    uint32_t    ui32Written;            // Characters accepted by Debug_write()
+    uint32_t    ui32Dropped;            // and lost because the buffer was full
+    uint32_t    ui32Blocked;            // Times Debug_write() waited for space (DEBUG_BLOCK)
+} sDebugStats;
+
+
+
 #if (HW_ENABLE_DEBUG_UART==1) && defined(DEBUG)
 
 bool Debug_InitUART( void );
 void Debug_FlushTxBuffer(void);
 uint32_t Debug_write(const char *pcBuf, uint32_t ui32Len);
-void Debug_printf(const char *pcString, ...);
-void Debug_vprintf(const char *pcString, va_list vaArgP);
+uint32_t Debug_printf(const char *pcString, ...);
+uint32_t Debug_vprintf(const char *pcString, va_list vaArgP);
+uint32_t Debug_printArgs(const char *pcString, const uintptr_t* puiArgs, uint32_t nArgs);
+void Debug_GetStats( sDebugStats* pStats );
+
+// Not for the client, for a static vector table, see HW_STATIC_VECTORS
+void DebugUARTIntHandler( void );
 
 #else
 
@@ -38,6 +57,8 @@ void Debug_vprintf(const char *pcString, va_list vaArgP);
 #define     Debug_write(buf, len)
 #define     Debug_printf(format, ...)
 #define     Debug_vprintf(format, valist)
+#define     Debug_printArgs(format, args, nargs)
+#define     Debug_GetStats(pStats)
 
 
 #endif  // (HW_ENABLE_DEBUG_UART==1) && defined(DEBUG)
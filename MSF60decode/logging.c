@@ -13,10 +13,14 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdarg.h>
 #include <stdio.h>
 
+#include "driverlib/interrupt.h"
+
 #include "config.h"
 #include "hardware.h"
+#include "radio.h"
 
 #include "logging.h"
 
@@ -27,100 +31,419 @@
 
 
 // These externs will be visible in a Debug build
-extern bool getBit(uint8_t* bitarray, int bitnum);
-extern uint8_t A_bits[ 8 ];
-extern uint8_t B_bits[ 8 ];
+extern bool getBit(uint64_t frame, unsigned bitnum);
+
+
 
+#if (LOG_DEFERRED == 1)
 
+#define     LOG_TRACE_MASK      (LOG_TRACE_ENTRIES - 1)
+
+#if (LOG_TRACE_ENTRIES & LOG_TRACE_MASK) != 0
+#error "LOG_TRACE_ENTRIES must be a power of 2"
+#endif
 
-#if (SHOW_LOG_BIT_DUMP == 1)
 
 /**
- * Dump out the entire A and B arrays with the bit numbers
- *
+ * A deferred log record. pcFormat is written last and cleared once the record has been
+ * formatted, so LOG_Flush() never picks up a record that's still being filled in.
+ */
+typedef struct {
+    const char* volatile pcFormat;
+    uint32_t    timestamp;
+    uint8_t     type;
+    uint8_t     nArgs;
+    uintptr_t   args[ LOG_TRACE_MAX_ARGS ];     // Wide enough for a %s pointer on a 64 bit host
+} sLogRecord;
+
+
+/**
+ * Ring of log records. The indices are free running and only masked when the ring is
+ * accessed. LOGprintf() may be called from interrupt handlers as well as thread context
+ * so a record is claimed with interrupts masked, just long enough to bump the write index.
+ */
+STATIC sLogRecord LogTrace[ LOG_TRACE_ENTRIES ];
+STATIC volatile uint32_t LogWriteIndex = 0;
+STATIC volatile uint32_t LogReadIndex = 0;
+
+// Count of records dropped because the ring was full
+STATIC volatile uint32_t nLogDropped = 0;
+
+#endif
+
+
+// Count of messages in each category that were dropped, or cut short because the debug UART buffer was full
+STATIC volatile uint32_t LogDropCount[ LOG_NUM_TYPES ];
+
+// The enabled logging categories, one bit per eMSFLogType. LOGprintf() tests it.
+volatile uint32_t g_LogMask = LOG_DEFAULT_MASK;
+
+
+
+/**
+ * Dump out the entire A and B arrays with the bit numbers. Each line is built
+ * up and written in one go. Returns the number of characters dropped.
  */
+STATIC uint32_t
+dumpBits( uint64_t A, uint64_t B )
+{
+    char line[ 2 + 59 + 1 ];
+    uint32_t nDropped = 0;
+    int row, i;
+
+    for( row=0 ; row<5 ; row++ )
+    {
+        line[ 0 ] = "   AB"[ row ];
+        line[ 1 ] = ' ';
+
+        for( i=1 ; i<=59 ; i++)
+        {
+            switch (row)
+            {
+                case 0:     line[ i+1 ] = '0' + i/10;                       break;
+                case 1:     line[ i+1 ] = '0' + (i % 10);                   break;
+                case 2:     line[ i+1 ] = '-';                              break;
+                case 3:     line[ i+1 ] = (getBit(A, i)) ? '1' : '0';       break;
+                default:    line[ i+1 ] = (getBit(B, i)) ? '1' : '0';       break;
+            }
+        }
+
+        line[ 2 + 59 ] = '\n';
+        nDropped += sizeof(line) - Debug_write(line, sizeof(line));
+    }
+
+    return nDropped;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       LOG_SetMask()
+*
+* DESCRIPTION
+*       Choose which logging categories are output
+*
+* PARAMETERS
+*       uint32_t        mask        LOG_MASK(type) bits of the categories to enable
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*       Takes effect immediately. Messages already saved by the deferred
+*       logger are still output.
+*
+********************************************************************/
 void
-dumpBits( void )
+LOG_SetMask( uint32_t mask )
 {
-    int i;
-
-    Console_write("  ", 2);
-    for( i=1 ; i<=59 ; i++)
-        Console_printf("%c", '0' + i/10);
-    Console_printf("\n  ");
-    for( i=1 ; i<=59 ; i++)
-        Console_printf("%c", '0' + (i % 10) );
-    Console_printf("\n");
-
-    Console_write("  ", 2);
-    for( i=0 ; i<59 ; i++)
-        Console_printf("%c", '-' );
-    Console_printf("\n");
-
-    Console_write("A ", 2);
-    for( i=1 ; i<=59 ; i++)
-        Console_printf("%c", (getBit(A_bits, i)) ? '1' : '0');
-    Console_printf("\nB ");
-    for( i=1 ; i<=59 ; i++)
-        Console_printf("%c", (getBit(B_bits, i)) ? '1' : '0');
-    Console_printf("\n");
+    g_LogMask = mask;
+}
+
 
+
+/*******************************************************************
+* NAME
+*       LOG_GetMask()
+*
+* DESCRIPTION
+*       Get the enabled logging categories
+*
+* PARAMETERS
+*       None
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       uint32_t        LOG_MASK(type) bits of the enabled categories
+*
+* NOTES
+*
+********************************************************************/
+uint32_t
+LOG_GetMask( void )
+{
+    return g_LogMask;
 }
 
-#endif
+
+
+/**
+ * Count a message that was lost or cut short. LOGprintf() may be called from
+ * an interrupt handler so mask interrupts around the increment.
+ */
+STATIC void
+LogCountDrop( eMSFLogType type )
+{
+    bool bMasked = IntMasterDisable();
+
+    if (type < LOG_NUM_TYPES)
+        LogDropCount[ type ]++;
+
+    if (!bMasked)
+        IntMasterEnable();
+}
+
+
+
+/*******************************************************************
+* NAME
+*       LOG_GetDropCount()
+*
+* DESCRIPTION
+*       Get the number of messages in a category that were lost
+*
+* PARAMETERS
+*       eMSFLogType     type        Message category
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       uint32_t        Messages dropped, or cut short because the debug
+*                       UART transmit buffer was full
+*
+* NOTES
+*       See also Debug_GetStats()
+*
+********************************************************************/
+uint32_t
+LOG_GetDropCount( eMSFLogType type )
+{
+    return (type < LOG_NUM_TYPES) ? LogDropCount[ type ] : 0;
+}
 
 
 
+#if (LOG_DEFERRED == 1)
+
+/**
+ * Count the arguments a format string takes, up to LOG_TRACE_MAX_ARGS. Bit n of *pStrings
+ * is set if argument n is a %s string pointer, the rest are 32 bit values.
+ */
+STATIC unsigned
+CountArgs( const char *pcString, uint32_t* pStrings )
+{
+    unsigned nArgs = 0;
+
+    *pStrings = 0;
+
+    while ((*pcString) && (nArgs < LOG_TRACE_MAX_ARGS))
+    {
+        if (*pcString++ == '%')
+        {
+            if (*pcString == '%')
+            {
+                pcString++;
+                continue;
+            }
+
+            // Skip the width to the conversion character
+            while ((*pcString >= '0') && (*pcString <= '9'))
+                pcString++;
+
+            if (*pcString == 's')
+                *pStrings |= 1 << nArgs;
+
+            nArgs++;
+        }
+    }
+
+    return nArgs;
+}
 
 
+
+/*******************************************************************
+* NAME
+*       LOG_Output()
+*
+* DESCRIPTION
+*       Save a log message to be formatted later by LOG_Flush()
+*
+* PARAMETERS
+*       eMSFLogType     type        Message category
+*       const char*     pcString    Format string, see Debug_vprintf()
+*       ...                         Up to LOG_TRACE_MAX_ARGS 32 bit or %s arguments
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*
+* Called by the LOGprintf() macro if the category is enabled.
+*
+* %s arguments are saved as pointers, so they must still be valid when
+* LOG_Flush() formats them. Everything else is taken as 32 bits.
+*
+* Only the arguments are copied, so this is cheap enough to call from an
+* interrupt handler. If the ring is full the message is dropped and counted.
+*
+********************************************************************/
 void
-LOGprintf( eMSFLogType type, const char *pcString, ...)
+LOG_Output( eMSFLogType type, const char *pcString, ...)
 {
     va_list args;
+    sLogRecord* pRecord;
+    uint32_t ui32Write;
+    uint32_t ui32Strings = 0;
+    unsigned index;
+    bool bMasked, bClaimed;
+
+    // Claim the next record
+    bMasked = IntMasterDisable();
+    ui32Write = LogWriteIndex;
+    bClaimed  = (ui32Write - LogReadIndex) < LOG_TRACE_ENTRIES;
+    if (bClaimed)
+        LogWriteIndex = ui32Write + 1;
+    else
+        nLogDropped++;
+    if (!bMasked)
+        IntMasterEnable();
 
-    // Start varargs processing.
+    if (!bClaimed)
+    {
+        LogCountDrop( type );
+        return;
+    }
+
+    pRecord = &LogTrace[ ui32Write & LOG_TRACE_MASK ];
+    pRecord->timestamp = Radio_GetTickCount();
+    pRecord->type      = type;
+
+    // A LOG_BIT_DUMP passes the A and B words as 4 halves, high word first
     va_start(args, pcString);
+    pRecord->nArgs = (type == LOG_BIT_DUMP) ? 4 : CountArgs( pcString, &ui32Strings );
+    for (index = 0 ; index < pRecord->nArgs ; index++)
+    {
+        if (ui32Strings & (1 << index))
+            pRecord->args[ index ] = (uintptr_t) va_arg(args, const char*);
+        else
+            pRecord->args[ index ] = va_arg(args, uint32_t);
+    }
+    va_end(args);
 
-#if (SHOW_LOG_INFO == 1)
-    if (type == LOG_INFO)
-        Debug_vprintf(pcString, args);
-    else
-#endif
+    // The record is complete
+    pRecord->pcFormat = pcString;
+}
 
-#if (SHOW_LOG_SYNC_MSGS == 1)
-    if (type == LOG_SYNC_MSG)
-        Debug_vprintf(pcString, args);
-    else
-#endif
 
-#if (SHOW_LOG_EVENTS == 1)
-    if (type == LOG_EVENT)
-        Debug_vprintf(pcString, args);
-    else
-#endif
 
-#if (SHOW_LOG_EDGE_ERRORS == 1)
-    if (type == LOG_EDGE_ERROR)
-        Debug_vprintf(pcString, args);
-    else
-#endif
+/*******************************************************************
+* NAME
+*       LOG_Flush()
+*
+* DESCRIPTION
+*       Format the saved log messages to the debug UART
+*
+* PARAMETERS
+*       None
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*
+* Call from thread context. MSF_Process() calls it after decoding each
+* batch of edges. Every message is prefixed with the tick count it was
+* logged at.
+*
+********************************************************************/
+void
+LOG_Flush( void )
+{
+static uint32_t nLogReported = 0;
+
+    uint32_t ui32Read = LogReadIndex;
+    sLogRecord* pRecord;
+    uint32_t nDropped;
+
+    while (ui32Read != LogWriteIndex)
+    {
+        pRecord = &LogTrace[ ui32Read & LOG_TRACE_MASK ];
+
+        // Still being written, try again next time
+        if (pRecord->pcFormat == NULL)
+            break;
+
+        nDropped = Debug_printf("%u: ", pRecord->timestamp);
+
+        if (pRecord->type == LOG_BIT_DUMP)
+        {
+            nDropped += Debug_printf("\n");
+            nDropped += dumpBits( ((uint64_t) pRecord->args[ 0 ] << 32) | pRecord->args[ 1 ],
+                                  ((uint64_t) pRecord->args[ 2 ] << 32) | pRecord->args[ 3 ] );
+        }
+        else
+            nDropped += Debug_printArgs( pRecord->pcFormat, pRecord->args, pRecord->nArgs );
+
+        // The debug UART buffer filled up part way through
+        if (nDropped)
+            LogCountDrop( (eMSFLogType) pRecord->type );
+
+        // Release the record
+        pRecord->pcFormat = NULL;
+        LogReadIndex = ++ui32Read;
+    }
+
+    if (nLogDropped != nLogReported)
+    {
+        Debug_printf("%u log messages dropped\n", nLogDropped - nLogReported);
+        nLogReported = nLogDropped;
+    }
+}
+
+
+#else // LOG_DEFERRED
 
-#if (SHOW_LOG_BCD_ERRORS == 1)
-    if (type == LOG_BCD_ERROR)
-        Debug_vprintf(pcString, args);
-    else
-#endif
 
-#if (SHOW_LOG_BIT_DUMP == 1)
+void
+LOG_Output( eMSFLogType type, const char *pcString, ...)
+{
+    va_list args;
+    uint32_t nDropped;
+    uint64_t A, B;
+
+    // Start varargs processing.
+    va_start(args, pcString);
+
+    // The A and B words are passed as 4 halves, high word first
     if (type == LOG_BIT_DUMP)
-        dumpBits();
-#endif
+    {
+        A  = (uint64_t) va_arg(args, uint32_t) << 32;
+        A |= va_arg(args, uint32_t);
+        B  = (uint64_t) va_arg(args, uint32_t) << 32;
+        B |= va_arg(args, uint32_t);
+        va_end(args);
+
+        if (dumpBits( A, B ))
+            LogCountDrop( type );
+        return;
+    }
 
+    nDropped = Debug_vprintf(pcString, args);
 
     va_end(args);
+
+    // The debug UART buffer filled up part way through
+    if (nDropped)
+        LogCountDrop( type );
 }
 
 
+#endif // LOG_DEFERRED
+
 #endif // (HW_ENABLE_DEBUG_UART==1) && defined(DEBUG)
 
 
@@ -12,6 +12,14 @@
 #define _LOGGING_H_
 
 
+// System includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// Our includes
+#include "config.h"
+
+
 
 /**
  * NOTE: logging is only possible in a Debug build with the debug
@@ -25,7 +33,9 @@
 
 
 /**
- *  Enable individual logging categories
+ * The logging categories enabled at startup. Categories can be turned on and
+ * off at run time with LOG_SetMask(), so everything is compiled in and a
+ * disabled LOGprintf() only costs a test of one bit in g_LogMask.
  */
 #define     SHOW_LOG_INFO               0
 #define     SHOW_LOG_SYNC_MSGS          1
@@ -36,6 +46,21 @@
 
 
 
+/**
+ * Deferred logging. LOGprintf() only saves the format string pointer, a timestamp
+ * and the raw 32 bit or string pointer arguments in a ring of LOG_TRACE_ENTRIES
+ * records, which must be a power of 2. The records are formatted to the debug UART
+ * later, in thread context, by LOG_Flush(). A format with more than LOG_TRACE_MAX_ARGS arguments prints 0 for
+ * the rest. %s arguments must point at strings that are still valid when flushed.
+ *
+ * Set LOG_DEFERRED to 0 to format every message immediately.
+ */
+#define     LOG_DEFERRED                1
+#define     LOG_TRACE_ENTRIES           32
+#define     LOG_TRACE_MAX_ARGS          4
+
+
+
 /**
  *  Log message categories.
  */
@@ -45,16 +70,51 @@ typedef enum tag_msf_log_type {
     LOG_BIT_DUMP,
     LOG_CARRIER_EVENT,
     LOG_EDGE_ERROR,
-    LOG_BCD_ERROR
+    LOG_BCD_ERROR,
+    //
+    LOG_NUM_TYPES
 } eMSFLogType;
 
 
+// The bit in the log mask for a category
+#define     LOG_MASK(type)              (1UL << (type))
+
+// Log mask at startup, from the SHOW_LOG_* options
+#define     LOG_DEFAULT_MASK            ( ((SHOW_LOG_INFO        == 1) ? LOG_MASK(LOG_INFO)          : 0) \
+                                        | ((SHOW_LOG_SYNC_MSGS   == 1) ? LOG_MASK(LOG_SYNC_MSG)      : 0) \
+                                        | ((SHOW_LOG_BIT_DUMP    == 1) ? LOG_MASK(LOG_BIT_DUMP)      : 0) \
+                                        | ((SHOW_LOG_EVENTS      == 1) ? LOG_MASK(LOG_CARRIER_EVENT) : 0) \
+                                        | ((SHOW_LOG_EDGE_ERRORS == 1) ? LOG_MASK(LOG_EDGE_ERROR)    : 0) \
+                                        | ((SHOW_LOG_BCD_ERRORS  == 1) ? LOG_MASK(LOG_BCD_ERROR)     : 0) )
+
+
 
 
 #if defined(DEBUG) && (HW_ENABLE_DEBUG_UART==1)
-void LOGprintf(eMSFLogType type, const char *pcString, ...);
+
+// The enabled categories. Tested before the call so a disabled message doesn't evaluate its arguments.
+extern volatile uint32_t g_LogMask;
+
+#define LOGprintf(type, ...)            do { if (g_LogMask & LOG_MASK(type)) LOG_Output((type), __VA_ARGS__); } while (0)
+
+void LOG_Output(eMSFLogType type, const char *pcString, ...);
+void LOG_SetMask(uint32_t mask);
+uint32_t LOG_GetMask(void);
+uint32_t LOG_GetDropCount(eMSFLogType type);
+
 #else
+
 #define LOGprintf(type, format, ...)
+#define LOG_SetMask(mask)
+#define LOG_GetMask()                   0
+#define LOG_GetDropCount(type)          0
+
+#endif
+
+#if defined(DEBUG) && (HW_ENABLE_DEBUG_UART==1) && (LOG_DEFERRED==1)
+void LOG_Flush(void);
+#else
+#define LOG_Flush()
 #endif
 
 
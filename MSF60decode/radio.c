@@ -0,0 +1,500 @@
+
+/********************************************************************************
+ * @file    radio.c
+ * @author  Tony Hanratty
+ * @date    14-Oct-2026
+ *
+ * @brief   TM4C1294 interface to the MSF radio receiver
+ *
+ * @notes   All the driverlib calls the decoder needs: the radio GPIO & ISR, the
+ *          optional capture timer, the tick count and the DWT cycle counter.
+ *          The pins, timer and interrupts are configured in config.h
+ *
+ ********************************************************************************/
+
+
+// System includes
+#include <stdbool.h>
+#include <stdint.h>
+
+// TI platform
+#include "inc/hw_memmap.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_types.h"
+#include "inc/hw_timer.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/pin_map.h"
+#include "driverlib/gpio.h"
+#include "driverlib/timer.h"
+
+// Our includes
+#include "config.h"
+#include "hardware.h"
+#include "capture.h"
+
+// This file's include
+#include "radio.h"
+
+
+
+// The capture timer is a 16 bit counter extended to 24 bits by the prescaler
+#define     CAPTURE_COUNT_BITS      24
+#define     CAPTURE_COUNT_MASK      ((1UL << CAPTURE_COUNT_BITS) - 1)
+
+// Cortex-M4 DWT cycle counter, for the optional decoder statistics
+#define     CM4_DEMCR               0xE000EDFC      // Debug Exception and Monitor Control
+#define     CM4_DEMCR_TRCENA        0x01000000      // Enables the DWT
+#define     CM4_DWT_CTRL            0xE0001000
+#define     CM4_DWT_CTRL_CYCCNTENA  0x00000001
+#define     CM4_DWT_CYCCNT          0xE0001004
+
+
+
+#if (HW_ENABLE_CAPTURE_TIMER == 1) && (MSF_NUM_RECEIVERS > 1)
+#error "The capture timer only has one input, it can't be used with more than one receiver"
+#endif
+
+#if (RADIO_INT_PRIORITY == 0)
+#error "A BASEPRI of 0 masks nothing, so Radio_IntDisable() can't mask a radio ISR at the most urgent priority"
+#endif
+
+
+
+// The data pin of each receiver, all on RADIO_PORT_BASE, and all of them together
+STATIC const uint8_t RadioDataPins[ MSF_NUM_RECEIVERS ] = RADIO_DATA_PINS;
+STATIC uint8_t RadioDataMask = 0;
+
+
+
+#if (HW_ENABLE_CAPTURE_TIMER == 1)
+
+// CPU clock frequency in Hz. The capture timer runs from the system clock.
+extern uint32_t g_SysClockSpeed;
+
+// Number of times the 24 bit capture counter has wrapped. Extends edge timestamps to 32 bits.
+STATIC volatile uint32_t CaptureWrapCount = 0;
+
+#else
+
+// We need access to a millisecond resolution uin32_t tick counter for timing.
+extern volatile uint32_t g_msSysTick;
+
+#endif
+
+
+
+/**
+ * Pass an edge to the decoder with the level of the receiver's data pin after it.
+ * Any capture running and the LED follow receiver 0.
+ */
+STATIC void
+QueueRadioEdge( unsigned receiver, uint32_t event_time )
+{
+    uint32_t level = (GPIOPinRead(RADIO_PORT_BASE, RadioDataPins[ receiver ])) ? 1 : 0;
+
+    MSF_QueueCarrierEdge( receiver, level, event_time );
+
+    if (receiver == 0)
+    {
+#if (MSF_CAPTURE_EDGES > 0)
+        Capture_Edge( level, event_time );
+#endif
+        SetLED( level );
+    }
+}
+
+
+
+#if (HW_ENABLE_CAPTURE_TIMER == 1)
+
+/**
+ * The capture timer ISR. The timer latches the time of each edge on the radio data
+ * pin in hardware so interrupt latency doesn't affect the timestamp. The timeout
+ * interrupt extends the 24 bit timer count to 32 bits.
+ *
+ * If the counter wrapped and an edge was captured before this ISR ran, a large
+ * capture value means the edge came before the wrap.
+ *
+ * Not static, so it can be named in a static vector table, see HW_STATIC_VECTORS.
+ */
+void
+RadioCaptureIntHandler( void )
+{
+#if (MSF_ENABLE_STATS == 1)
+    uint32_t stat_start = Radio_GetCycleCount();
+#endif
+    uint32_t int_status = TimerIntStatus( RADIO_TIMER_BASE, true );
+    uint32_t capture, wraps;
+
+    TimerIntClear( RADIO_TIMER_BASE, int_status );
+
+    capture = TimerValueGet( RADIO_TIMER_BASE, RADIO_TIMER ) & CAPTURE_COUNT_MASK;
+    wraps   = CaptureWrapCount;
+
+    if (int_status & RADIO_TIMER_TIMEOUT_EVENT)
+    {
+        CaptureWrapCount = wraps + 1;
+
+        if (capture < (CAPTURE_COUNT_MASK / 2))
+            wraps++;
+
+#if (MSF_CAPTURE_EDGES > 0)
+        // A gap between edges longer than the tick count wraps in would be recorded short
+        Capture_Idle( Radio_GetTickCount() );
+#endif
+    }
+
+    if (int_status & RADIO_TIMER_CAPTURE_EVENT)
+    {
+        QueueRadioEdge( 0, (wraps << CAPTURE_COUNT_BITS) | capture );
+    }
+
+#if (MSF_ENABLE_STATS == 1)
+    MSF_CountRadioIsr( stat_start );
+#endif
+}
+
+#else
+
+/**
+ * This MSF radio ISR just timestamps the new carrier signal level and
+ * queues it for the decoder. All the receivers share the port interrupt,
+ * every pin that changed gets the same timestamp.
+ *
+ * Not static, so it can be named in a static vector table, see HW_STATIC_VECTORS.
+ */
+void
+RadioGpioIntHandler( void )
+{
+#if (MSF_ENABLE_STATS == 1)
+    uint32_t stat_start = Radio_GetCycleCount();
+#endif
+    uint32_t event_time = g_msSysTick;
+    uint32_t int_status = GPIOIntStatus( RADIO_PORT_BASE, true ) & RadioDataMask;
+    unsigned receiver;
+
+    GPIOIntClear( RADIO_PORT_BASE, int_status );
+
+    for (receiver = 0 ; receiver < MSF_NUM_RECEIVERS ; receiver++)
+    {
+        if (int_status & RadioDataPins[ receiver ])
+            QueueRadioEdge( receiver, event_time );
+    }
+
+#if (MSF_ENABLE_STATS == 1)
+    MSF_CountRadioIsr( stat_start );
+#endif
+}
+
+#endif // HW_ENABLE_CAPTURE_TIMER
+
+
+
+/*******************************************************************
+* NAME
+*       Radio_Init()
+*
+* DESCRIPTION
+*       Configure the GPIO port to interface with the MSF radio card
+*
+* PARAMETERS
+*       None
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*
+* The radio is left disabled, see Radio_Enable(). With more than one
+* receiver RADIO_ENABLE_BIT enables all of them. The radio interrupt is
+* set to RADIO_INT_PRIORITY.
+*
+*
+********************************************************************/
+void
+Radio_Init( void )
+{
+    unsigned receiver;
+
+    for (receiver = 0 ; receiver < MSF_NUM_RECEIVERS ; receiver++)
+        RadioDataMask |= RadioDataPins[ receiver ];
+
+    // Enable the GPIO port
+    SysCtlPeripheralEnable(RADIO_GPIO_SYSCTL_PERIPH);
+    SysCtlPeripheralReset(RADIO_GPIO_SYSCTL_PERIPH);
+    while(!SysCtlPeripheralReady( RADIO_GPIO_SYSCTL_PERIPH ));
+
+    // Keep the radio interface clocked if the client sleeps with peripheral clock gating enabled
+    SysCtlPeripheralSleepEnable(RADIO_GPIO_SYSCTL_PERIPH);
+    SysCtlPeripheralDeepSleepEnable(RADIO_GPIO_SYSCTL_PERIPH);
+
+    // Configure the required pins
+    GPIOPinTypeGPIOOutput( RADIO_PORT_BASE, RADIO_ENABLE_BIT );
+    GPIODirModeSet( RADIO_PORT_BASE, RADIO_ENABLE_BIT, GPIO_DIR_MODE_OUT );
+    GPIOPadConfigSet(RADIO_PORT_BASE, RADIO_ENABLE_BIT, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD);
+
+    // This pin must be low to enable the output bit stream. Leave it high (disabled) for now.
+    GPIOPinWrite(RADIO_PORT_BASE, RADIO_ENABLE_BIT, RADIO_ENABLE_BIT );
+
+    // Optionally blink a LED when carrier changes
+    InitLED();
+
+#if (MSF_ENABLE_STATS == 1)
+    // Start the cycle counter used to time the decoder
+    HWREG( CM4_DEMCR )    |= CM4_DEMCR_TRCENA;
+    HWREG( CM4_DWT_CTRL ) |= CM4_DWT_CTRL_CYCCNTENA;
+#endif
+
+#if (HW_ENABLE_CAPTURE_TIMER == 1)
+
+    // The data pin is the timer's CCP input. Its level can still be read through the GPIO data register.
+    GPIOPinConfigure( RADIO_DATA_PIN_CONFIG );
+    GPIOPinTypeTimer( RADIO_PORT_BASE, RADIO_DATA_BIT );
+
+    SysCtlPeripheralEnable(RADIO_TIMER_SYSCTL_PERIPH);
+    SysCtlPeripheralReset(RADIO_TIMER_SYSCTL_PERIPH);
+    while(!SysCtlPeripheralReady( RADIO_TIMER_SYSCTL_PERIPH ));
+    SysCtlPeripheralSleepEnable(RADIO_TIMER_SYSCTL_PERIPH);
+    SysCtlPeripheralDeepSleepEnable(RADIO_TIMER_SYSCTL_PERIPH);
+
+    // Free running 24 bit up counter that captures the time of both rising & falling edges
+    TimerConfigure( RADIO_TIMER_BASE, RADIO_TIMER_CONFIG );
+    TimerControlEvent( RADIO_TIMER_BASE, RADIO_TIMER, TIMER_EVENT_BOTH_EDGES );
+    TimerLoadSet( RADIO_TIMER_BASE, RADIO_TIMER, 0xFFFF );
+    TimerPrescaleSet( RADIO_TIMER_BASE, RADIO_TIMER, 0xFF );
+
+#if (HW_STATIC_VECTORS == 0)
+    TimerIntRegister( RADIO_TIMER_BASE, RADIO_TIMER, RadioCaptureIntHandler );
+#endif
+    TimerIntEnable( RADIO_TIMER_BASE, RADIO_TIMER_CAPTURE_EVENT | RADIO_TIMER_TIMEOUT_EVENT );
+    TimerEnable( RADIO_TIMER_BASE, RADIO_TIMER );
+
+    IntPrioritySet( RADIO_TIMER_INT, RADIO_INT_PRIORITY );
+    IntEnable( RADIO_TIMER_INT );
+
+#else
+
+    GPIOPinTypeGPIOInput( RADIO_PORT_BASE, RadioDataMask);
+    GPIODirModeSet( RADIO_PORT_BASE, RadioDataMask, GPIO_DIR_MODE_IN );
+
+    // Configure GPIO interrupt for both rising & falling edges on the input pins
+#if (HW_STATIC_VECTORS == 0)
+    GPIOIntRegister( RADIO_PORT_BASE, RadioGpioIntHandler );
+#endif
+    GPIOIntTypeSet( RADIO_PORT_BASE, RadioDataMask, GPIO_BOTH_EDGES );
+    GPIOIntEnable( RADIO_PORT_BASE, RadioDataMask );
+
+    IntPrioritySet( RADIO_INT_GPIO, RADIO_INT_PRIORITY );
+    IntEnable( RADIO_INT_GPIO );
+
+#endif // HW_ENABLE_CAPTURE_TIMER
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Radio_Enable()
+*
+* DESCRIPTION
+*       Enable/Disable the MSF60 radio bit stream
+*
+* PARAMETERS
+*       bool    state           true  : Enable radio output
+*                               false : Disable radio output
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*
+* Toggles a GPIO pin to control the radio. For Different hardware, edit
+* this function to do whatever's necessary to enable the MSF bit stream.
+* NB This pin is active low for my hardware.
+*
+*
+********************************************************************/
+void
+Radio_Enable( bool state )
+{
+    GPIOPinWrite(RADIO_PORT_BASE, RADIO_ENABLE_BIT, (state) ? 0 : RADIO_ENABLE_BIT );
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Radio_GetTickCount()
+*
+* DESCRIPTION
+*       Read the current tick count in the same time base as the edge timestamps
+*
+* PARAMETERS
+*       None
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       uint32_t        Ticks, see Radio_GetTicksPerMs()
+*
+* NOTES
+*
+*
+********************************************************************/
+uint32_t
+Radio_GetTickCount( void )
+{
+#if (HW_ENABLE_CAPTURE_TIMER == 1)
+    uint32_t wraps, count;
+
+    // Re-read if the counter wrapped while we were looking at it
+    do {
+        wraps = CaptureWrapCount;
+        count = HWREG( RADIO_TIMER_BASE + RADIO_TIMER_VALUE_REG ) & CAPTURE_COUNT_MASK;
+    } while (wraps != CaptureWrapCount);
+
+    return (wraps << CAPTURE_COUNT_BITS) | count;
+#else
+    return g_msSysTick;
+#endif
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Radio_GetTicksPerMs()
+*
+* DESCRIPTION
+*       Get the rate of the tick count
+*
+* PARAMETERS
+*       None
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       uint32_t        Ticks per millisecond
+*
+* NOTES
+*
+* 1 for g_msSysTick, the system clock in kHz with the capture timer.
+*
+*
+********************************************************************/
+uint32_t
+Radio_GetTicksPerMs( void )
+{
+#if (HW_ENABLE_CAPTURE_TIMER == 1)
+    return g_SysClockSpeed / 1000;
+#else
+    return 1;
+#endif
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Radio_GetCycleCount()
+*
+* DESCRIPTION
+*       Read the CPU cycle counter
+*
+* PARAMETERS
+*       None
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       uint32_t        DWT CYCCNT
+*
+* NOTES
+*
+* Only counts once Radio_Init() has enabled it, with MSF_ENABLE_STATS.
+*
+*
+********************************************************************/
+uint32_t
+Radio_GetCycleCount( void )
+{
+    return HWREG( CM4_DWT_CYCCNT );
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Radio_IntDisable()
+*
+* DESCRIPTION
+*       Stop the radio ISR running, e.g. while reading data it updates
+*
+* PARAMETERS
+*       None
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       uint32_t        The BASEPRI mask before, pass this to
+*                       Radio_IntRestore()
+*
+* NOTES
+*
+* Only masks interrupts at RADIO_INT_PRIORITY or less urgent, with BASEPRI,
+* so more urgent interrupts keep running. A mask already as urgent or more
+* is left alone. They nest, and Radio_IntRestore() puts back whatever mask
+* the caller had.
+*
+*
+********************************************************************/
+uint32_t
+Radio_IntDisable( void )
+{
+    uint32_t mask = IntPriorityMaskGet();
+
+    // BASEPRI 0 masks nothing
+    if ((mask == 0) || (mask > RADIO_INT_PRIORITY))
+        IntPriorityMaskSet( RADIO_INT_PRIORITY );
+
+    return mask;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Radio_IntRestore()
+*
+* DESCRIPTION
+*       Undo Radio_IntDisable()
+*
+* PARAMETERS
+*       uint32_t    mask        Radio_IntDisable()'s return value
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*
+*
+********************************************************************/
+void
+Radio_IntRestore( uint32_t mask )
+{
+    IntPriorityMaskSet( mask );
+}
@@ -0,0 +1,59 @@
+/********************************************************************************
+ * @file    radio.h
+ * @author  Tony Hanratty
+ * @date    14-Oct-2026
+ *
+ * @brief   Interface between the decoder and the MSF radio hardware
+ *
+ * @notes   The decoder in MSF60decode.c makes no driverlib calls. Everything it
+ *          needs from the hardware is here. radio.c implements it for the
+ *          TM4C1294, the host replay tool has its own version for a PC.
+ ********************************************************************************/
+
+#ifndef _RADIO_H_
+#define _RADIO_H_
+
+
+// System includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// Our includes
+#include "config.h"
+
+
+
+/**
+ * Provided by the radio interface
+ */
+void Radio_Init( void );
+void Radio_Enable( bool state );
+uint32_t Radio_GetTickCount( void );
+uint32_t Radio_GetTicksPerMs( void );
+uint32_t Radio_GetCycleCount( void );
+uint32_t Radio_IntDisable( void );
+void Radio_IntRestore( uint32_t mask );
+
+// The radio ISR for a static vector table, see HW_STATIC_VECTORS
+#if (HW_ENABLE_CAPTURE_TIMER == 1)
+void RadioCaptureIntHandler( void );
+#else
+void RadioGpioIntHandler( void );
+#endif
+
+
+
+/**
+ * Provided by the decoder, called from the radio ISR. 'receiver' is the index of the
+ * radio's data pin in RADIO_DATA_PINS, 'level' the pin level after the edge and
+ * 'event_time' when it happened in ticks.
+ */
+void MSF_QueueCarrierEdge( unsigned receiver, uint32_t level, uint32_t event_time );
+
+#if (MSF_ENABLE_STATS == 1)
+void MSF_CountRadioIsr( uint32_t start_cycles );
+#endif
+
+
+
+#endif  // _RADIO_H_
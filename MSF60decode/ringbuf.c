@@ -0,0 +1,363 @@
+
+/********************************************************************************
+ * @file    ringbuf.c
+ * @author  Tony Hanratty
+ * @date    14-Oct-2026
+ *
+ * @brief   Single producer/single consumer byte ring buffer
+ *
+ * @notes   Used for the debug UART and console buffers and the radio edge queue.
+ *          Data is copied in and out as at most two contiguous spans with memcpy().
+ *
+ ********************************************************************************/
+
+
+// System includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// This file's include
+#include "ringbuf.h"
+
+
+
+/**
+ * The data must be in the ring before the index that hands it to the other
+ * side is updated, and vice versa. memcpy() is a library call to the TI
+ * compiler so it can't be moved past the volatile index access. GCC may
+ * inline it, so tell GCC not to reorder memory accesses across the barrier.
+ */
+#if defined(__GNUC__) && !defined(__TI_COMPILER_VERSION__)
+#define     RING_BARRIER()          __asm volatile ("" ::: "memory")
+#else
+#define     RING_BARRIER()
+#endif
+
+
+
+/*******************************************************************
+* NAME
+*       Ring_Count()
+*
+* DESCRIPTION
+*       Get the number of bytes in the ring
+*
+* PARAMETERS
+*       pRing       The ring
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       uint32_t    Bytes waiting to be read
+*
+* NOTES
+*       The count can only grow if called by the consumer, or shrink if
+*       called by the producer.
+*
+********************************************************************/
+uint32_t
+Ring_Count( const sRingBuffer* pRing )
+{
+    return pRing->ui32Write - pRing->ui32Read;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Ring_Space()
+*
+* DESCRIPTION
+*       Get the number of bytes that can be written to the ring
+*
+* PARAMETERS
+*       pRing       The ring
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       uint32_t    Free space in bytes
+*
+* NOTES
+*
+********************************************************************/
+uint32_t
+Ring_Space( const sRingBuffer* pRing )
+{
+    return pRing->ui32Size - (pRing->ui32Write - pRing->ui32Read);
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Ring_Write()
+*
+* DESCRIPTION
+*       Copy as much of a block of data as will fit into the ring
+*
+* PARAMETERS
+*       pRing       The ring
+*       pData       The data
+*       len         and its length in bytes
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       uint32_t    Number of bytes written
+*
+* NOTES
+*       Producer only.
+*
+********************************************************************/
+uint32_t
+Ring_Write( sRingBuffer* pRing, const void* pData, uint32_t len )
+{
+    uint32_t ui32Write = pRing->ui32Write;
+    uint32_t ui32Offset = ui32Write & (pRing->ui32Size - 1);
+    uint32_t ui32Span;
+
+    if (len > Ring_Space(pRing))
+        len = Ring_Space(pRing);
+
+    // Up to the end of the buffer, then any remainder from the start
+    ui32Span = pRing->ui32Size - ui32Offset;
+
+    if (ui32Span > len)
+        ui32Span = len;
+
+    memcpy(&pRing->pBuffer[ ui32Offset ], pData, ui32Span);
+    memcpy(pRing->pBuffer, (const uint8_t*) pData + ui32Span, len - ui32Span);
+
+    RING_BARRIER();
+    pRing->ui32Write = ui32Write + len;
+
+    return len;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Ring_Put()
+*
+* DESCRIPTION
+*       Copy a record into the ring if there's room for all of it
+*
+* PARAMETERS
+*       pRing       The ring
+*       pData       The record
+*       len         and its length in bytes
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       bool        false if the ring is too full, nothing is written
+*
+* NOTES
+*       Producer only.
+*
+********************************************************************/
+bool
+Ring_Put( sRingBuffer* pRing, const void* pData, uint32_t len )
+{
+    if (len > Ring_Space(pRing))
+        return false;
+
+    Ring_Write(pRing, pData, len);
+
+    return true;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Ring_Read()
+*
+* DESCRIPTION
+*       Copy up to len bytes out of the ring
+*
+* PARAMETERS
+*       pRing       The ring
+*       pData       Where to put the data
+*       len         Maximum number of bytes to read
+*
+* OUTPUTS
+*       *pData      The data
+*
+* RETURNS
+*       uint32_t    Number of bytes read
+*
+* NOTES
+*       Consumer only.
+*
+********************************************************************/
+uint32_t
+Ring_Read( sRingBuffer* pRing, void* pData, uint32_t len )
+{
+    uint32_t ui32Read = pRing->ui32Read;
+    uint32_t ui32Offset = ui32Read & (pRing->ui32Size - 1);
+    uint32_t ui32Span;
+
+    if (len > Ring_Count(pRing))
+        len = Ring_Count(pRing);
+
+    RING_BARRIER();
+
+    ui32Span = pRing->ui32Size - ui32Offset;
+
+    if (ui32Span > len)
+        ui32Span = len;
+
+    memcpy(pData, &pRing->pBuffer[ ui32Offset ], ui32Span);
+    memcpy((uint8_t*) pData + ui32Span, pRing->pBuffer, len - ui32Span);
+
+    RING_BARRIER();
+    pRing->ui32Read = ui32Read + len;
+
+    return len;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Ring_Get()
+*
+* DESCRIPTION
+*       Copy a record out of the ring if all of it is there
+*
+* PARAMETERS
+*       pRing       The ring
+*       pData       Where to put the record
+*       len         Length of the record in bytes
+*
+* OUTPUTS
+*       *pData      The record
+*
+* RETURNS
+*       bool        false if there's less than len bytes in the ring
+*
+* NOTES
+*       Consumer only.
+*
+********************************************************************/
+bool
+Ring_Get( sRingBuffer* pRing, void* pData, uint32_t len )
+{
+    if (len > Ring_Count(pRing))
+        return false;
+
+    Ring_Read(pRing, pData, len);
+
+    return true;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Ring_ReadSpan()
+*
+* DESCRIPTION
+*       Find the contiguous bytes waiting to be read, so they can be
+*       used in place, e.g. by the uDMA or to fill a UART FIFO
+*
+* PARAMETERS
+*       pRing       The ring
+*       offset      Number of unread bytes to skip, e.g. those already
+*                   handed to the uDMA
+*       ppData      Where to put a pointer to the first byte
+*
+* OUTPUTS
+*       *ppData     The first byte after 'offset' unread bytes
+*
+* RETURNS
+*       uint32_t    Number of bytes from *ppData up to the end of the data
+*                   or the end of the buffer, whichever is first
+*
+* NOTES
+*       Consumer only. Call Ring_Consume() once the bytes have been used.
+*
+********************************************************************/
+uint32_t
+Ring_ReadSpan( const sRingBuffer* pRing, uint32_t offset, const uint8_t** ppData )
+{
+    uint32_t ui32Start = pRing->ui32Read + offset;
+    uint32_t ui32Offset = ui32Start & (pRing->ui32Size - 1);
+    uint32_t ui32Len = pRing->ui32Write - ui32Start;
+
+    RING_BARRIER();
+
+    if (ui32Len > pRing->ui32Size - ui32Offset)
+        ui32Len = pRing->ui32Size - ui32Offset;
+
+    *ppData = &pRing->pBuffer[ ui32Offset ];
+
+    return ui32Len;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Ring_Consume()
+*
+* DESCRIPTION
+*       Release bytes found by Ring_ReadSpan() back to the producer
+*
+* PARAMETERS
+*       pRing       The ring
+*       len         Number of bytes used
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*       Consumer only.
+*
+********************************************************************/
+void
+Ring_Consume( sRingBuffer* pRing, uint32_t len )
+{
+    RING_BARRIER();
+    pRing->ui32Read += len;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       Ring_Flush()
+*
+* DESCRIPTION
+*       Discard everything in the ring
+*
+* PARAMETERS
+*       pRing       The ring
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*       Consumer only. From the producer side, disable the consumer's
+*       interrupt around the call.
+*
+********************************************************************/
+void
+Ring_Flush( sRingBuffer* pRing )
+{
+    pRing->ui32Read = pRing->ui32Write;
+}
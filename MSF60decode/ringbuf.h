@@ -0,0 +1,59 @@
+/********************************************************************************
+ * @file    ringbuf.h
+ * @author  Tony Hanratty
+ * @date    14-Oct-2026
+ *
+ * @brief   Single producer/single consumer byte ring buffer
+ ********************************************************************************/
+
+#ifndef _RINGBUF_H_
+#define _RINGBUF_H_
+
+
+// System includes
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/**
+ * A ring buffer shared by exactly one producer and one consumer, e.g. thread
+ * code and an ISR. Only the producer writes ui32Write and only the consumer
+ * writes ui32Read, so no interrupt masking is needed. The indices are free
+ * running and only masked to access the buffer, so the ring is empty when
+ * they're equal and all ui32Size bytes can be used. ui32Size must be a power of 2.
+ */
+typedef struct
+{
+    uint8_t*            pBuffer;
+    uint32_t            ui32Size;
+    volatile uint32_t   ui32Write;
+    volatile uint32_t   ui32Read;
+} sRingBuffer;
+
+
+// Static initialiser for a ring using the array 'buffer'
+#define     RING_BUFFER_INIT(buffer)        { (buffer), sizeof(buffer), 0, 0 }
+
+// Non zero if 'size' is a power of 2, for #if checks of the buffer sizes
+#define     RING_SIZE_OK(size)              (((size) != 0) && (((size) & ((size) - 1)) == 0))
+
+
+
+// Either side
+uint32_t Ring_Count( const sRingBuffer* pRing );
+uint32_t Ring_Space( const sRingBuffer* pRing );
+
+// Producer
+uint32_t Ring_Write( sRingBuffer* pRing, const void* pData, uint32_t len );
+bool Ring_Put( sRingBuffer* pRing, const void* pData, uint32_t len );
+
+// Consumer
+uint32_t Ring_Read( sRingBuffer* pRing, void* pData, uint32_t len );
+bool Ring_Get( sRingBuffer* pRing, void* pData, uint32_t len );
+uint32_t Ring_ReadSpan( const sRingBuffer* pRing, uint32_t offset, const uint8_t** ppData );
+void Ring_Consume( sRingBuffer* pRing, uint32_t len );
+void Ring_Flush( sRingBuffer* pRing );
+
+
+#endif  // _RINGBUF_H_
@@ -0,0 +1,250 @@
+
+/********************************************************************************
+ * @file    uartdma.c
+ * @author  Tony Hanratty
+ * @date    14-Oct-2026
+ *
+ * @brief   uDMA ping-pong transmit for the UART ring buffers
+ *
+ * @notes   Enabled by HW_ENABLE_UART_DMA in config.h. Instead of the UART TX
+ *          interrupt copying one byte at a time into the FIFO, each contiguous
+ *          segment of the ring is handed to the uDMA controller. The primary and
+ *          alternate control structures are used in ping-pong mode so the next
+ *          segment (e.g. after the ring wraps) is already queued when the first
+ *          completes. The UART raises UART_INT_DMATX at the end of each one.
+ *
+ ********************************************************************************/
+
+
+// System includes
+#include <stdbool.h>
+#include <stdint.h>
+
+// TI platform
+#include "inc/hw_memmap.h"
+#include "inc/hw_uart.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/uart.h"
+#include "driverlib/udma.h"
+
+// Our includes
+#include "config.h"
+
+// This file's include
+#include "uartdma.h"
+
+
+
+#if (HW_ENABLE_UART_DMA == 1)
+
+
+// The most items one uDMA control structure can transfer
+#define     UDMA_MAX_TRANSFER           1024
+
+// Index of a control structure in ui32Pending[]
+#define     HALF(select)                (((select) == UDMA_PRI_SELECT) ? 0 : 1)
+
+
+
+/**
+ * The uDMA channel control table, shared by every channel. The controller
+ * requires it to be 1024 byte aligned.
+ */
+#if defined(ccs)
+#pragma DATA_ALIGN(DmaControlTable, 1024)
+STATIC uint8_t DmaControlTable[ 1024 ];
+#else
+STATIC uint8_t DmaControlTable[ 1024 ] __attribute__ ((aligned(1024)));
+#endif
+
+STATIC bool bDmaEnabled = false;
+
+
+
+/**
+ * Enable the uDMA controller the first time any channel needs it
+ */
+STATIC void
+EnableDmaController( void )
+{
+    if(bDmaEnabled)
+        return;
+
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_UDMA);
+    SysCtlPeripheralReset(SYSCTL_PERIPH_UDMA);
+    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_UDMA));
+
+    uDMAEnable();
+    uDMAControlBaseSet(DmaControlTable);
+
+    bDmaEnabled = true;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       UartDma_InitTx()
+*
+* DESCRIPTION
+*       Set up a uDMA channel to drain a UART transmit ring
+*
+* PARAMETERS
+*       pTx         The ring and UART, with the public fields filled in
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*       Call after the UART is configured. The caller should enable
+*       UART_INT_DMATX and call UartDma_ServiceTx() from its UART ISR.
+*
+********************************************************************/
+void
+UartDma_InitTx( sUartDmaTx* pTx )
+{
+    EnableDmaController();
+
+    pTx->ui32Pending[0] = pTx->ui32Pending[1] = 0;
+    pTx->ui32Oldest = UDMA_PRI_SELECT;
+
+    uDMAChannelAssign(pTx->ui32Channel);
+    uDMAChannelAttributeDisable(pTx->ui32Channel, UDMA_ATTR_ALL);
+
+    // Byte at a time into the UART data register, in bursts of up to 4 when the FIFO asks for them
+    uDMAChannelControlSet(pTx->ui32Channel | UDMA_PRI_SELECT, UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE | UDMA_ARB_4);
+    uDMAChannelControlSet(pTx->ui32Channel | UDMA_ALT_SELECT, UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE | UDMA_ARB_4);
+
+    UARTDMAEnable(pTx->ui32UartBase, UART_DMA_TX);
+}
+
+
+
+/*******************************************************************
+* NAME
+*       UartDma_ServiceTx()
+*
+* DESCRIPTION
+*       Retire any completed transfers and queue the next parts of the ring
+*
+* PARAMETERS
+*       pTx         The ring and UART
+*
+* OUTPUTS
+*       The bytes sent are released from the ring
+*
+* RETURNS
+*       bool        true if a transfer is in flight, so there'll be another
+*                   UART_INT_DMATX when it completes
+*
+* NOTES
+*       This is the ring's consumer so only call it from the UART ISR, on
+*       UART_INT_DMATX or when the writer pends the interrupt after adding
+*       to the ring.
+*
+********************************************************************/
+bool
+UartDma_ServiceTx( sUartDmaTx* pTx )
+{
+    uint32_t ui32Select, ui32Len;
+    const uint8_t* pData;
+    bool bIdle;
+    int i;
+
+    // Retire the completed transfers, oldest first, to free their space in the ring
+    for(i = 0 ; i < 2 ; i++)
+    {
+        ui32Select = pTx->ui32Oldest;
+
+        if(!pTx->ui32Pending[ HALF(ui32Select) ] || (uDMAChannelModeGet(pTx->ui32Channel | ui32Select) != UDMA_MODE_STOP))
+            break;
+
+        Ring_Consume(pTx->pRing, pTx->ui32Pending[ HALF(ui32Select) ]);
+        pTx->ui32Pending[ HALF(ui32Select) ] = 0;
+        pTx->ui32Oldest ^= UDMA_ALT_SELECT;
+    }
+
+    // Stopped with nothing in flight? Start again from the primary.
+    bIdle = !uDMAChannelIsEnabled(pTx->ui32Channel);
+
+    if(bIdle && !pTx->ui32Pending[0] && !pTx->ui32Pending[1])
+        pTx->ui32Oldest = UDMA_PRI_SELECT;
+
+    // Queue the next contiguous segments of the ring in any free control structures
+    for(i = 0 ; i < 2 ; i++)
+    {
+        ui32Select = (pTx->ui32Pending[ HALF(pTx->ui32Oldest) ]) ? (pTx->ui32Oldest ^ UDMA_ALT_SELECT) : pTx->ui32Oldest;
+
+        if(pTx->ui32Pending[ HALF(ui32Select) ])
+            break;
+
+        ui32Len = Ring_ReadSpan(pTx->pRing, pTx->ui32Pending[0] + pTx->ui32Pending[1], &pData);
+
+        if(ui32Len > UDMA_MAX_TRANSFER)
+            ui32Len = UDMA_MAX_TRANSFER;
+
+        if(!ui32Len)
+            break;
+
+        uDMAChannelTransferSet(pTx->ui32Channel | ui32Select,
+                               UDMA_MODE_PINGPONG,
+                               (void*) pData,
+                               (void*) (pTx->ui32UartBase + UART_O_DR),
+                               ui32Len);
+
+        pTx->ui32Pending[ HALF(ui32Select) ] = ui32Len;
+    }
+
+    // (Re)start the channel on the oldest queued transfer
+    if(bIdle && pTx->ui32Pending[ HALF(pTx->ui32Oldest) ])
+    {
+        if(pTx->ui32Oldest == UDMA_ALT_SELECT)
+            uDMAChannelAttributeEnable(pTx->ui32Channel, UDMA_ATTR_ALTSELECT);
+        else
+            uDMAChannelAttributeDisable(pTx->ui32Channel, UDMA_ATTR_ALTSELECT);
+
+        uDMAChannelEnable(pTx->ui32Channel);
+    }
+
+    return (pTx->ui32Pending[0] || pTx->ui32Pending[1]);
+}
+
+
+
+/*******************************************************************
+* NAME
+*       UartDma_FlushTx()
+*
+* DESCRIPTION
+*       Abandon any transfers in progress and empty the ring
+*
+* PARAMETERS
+*       pTx         The ring and UART
+*
+* OUTPUTS
+*       The ring is emptied
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*       Call with the UART interrupt disabled. Bytes already in the UART
+*       FIFO are still sent.
+*
+********************************************************************/
+void
+UartDma_FlushTx( sUartDmaTx* pTx )
+{
+    uDMAChannelDisable(pTx->ui32Channel);
+
+    pTx->ui32Pending[0] = pTx->ui32Pending[1] = 0;
+    pTx->ui32Oldest = UDMA_PRI_SELECT;
+
+    Ring_Flush(pTx->pRing);
+}
+
+
+#endif  // (HW_ENABLE_UART_DMA == 1)
@@ -0,0 +1,53 @@
+/********************************************************************************
+ * @file    uartdma.h
+ * @author  Tony Hanratty
+ * @date    14-Oct-2026
+ *
+ * @brief   uDMA ping-pong transmit for the UART ring buffers
+ ********************************************************************************/
+
+#ifndef _UARTDMA_H_
+#define _UARTDMA_H_
+
+
+// System includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// Our includes
+#include "config.h"
+#include "ringbuf.h"
+
+
+
+#if (HW_ENABLE_UART_DMA == 1)
+
+
+/**
+ * A UART transmit ring drained by the uDMA controller. The owner of the ring
+ * fills in the first three fields and is its producer. The uDMA code is the
+ * consumer and releases the bytes as each transfer completes.
+ */
+typedef struct
+{
+    uint32_t            ui32UartBase;       // e.g. UART6_BASE
+    uint32_t            ui32Channel;        // Channel assignment, e.g. UDMA_CH11_UART6TX
+    sRingBuffer*        pRing;              // The transmit ring
+
+    // Private
+    uint32_t            ui32Pending[2];     // Bytes queued in the primary and alternate control structures
+    uint32_t            ui32Oldest;         // UDMA_PRI_SELECT or UDMA_ALT_SELECT, whichever was queued first
+} sUartDmaTx;
+
+
+
+void UartDma_InitTx( sUartDmaTx* pTx );
+bool UartDma_ServiceTx( sUartDmaTx* pTx );
+void UartDma_FlushTx( sUartDmaTx* pTx );
+
+
+#endif  // (HW_ENABLE_UART_DMA == 1)
+
+
+
+#endif  // _UARTDMA_H_
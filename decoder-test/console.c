@@ -18,34 +18,18 @@
 #include "driverlib/pin_map.h"
 #include "driverlib/gpio.h"
 #include "driverlib/uart.h"
+#include "driverlib/udma.h"
 
+#include "config.h"
+#include "ringbuf.h"
+#include "uartdma.h"
 #include "console.h"
 
 
 
-
-
-
-//*****************************************************************************
-// Transmit Buffer Macros
-//*****************************************************************************
-
-#define TX_BUFFER_EMPTY()                   (Console_TxBufferCount()==0)
-#define TX_BUFFER_FULL()                    (Console_TxBufferCount()==CONSOLE_TX_BUFFER_SIZE)
-
-#define ADVANCE_TX_BUFFER_INDEX(Index)      do {(Index) = ((Index) + 1) % CONSOLE_TX_BUFFER_SIZE;} while(0)
-
-
-
-//*****************************************************************************
-// Receive Buffer Macros
-//*****************************************************************************
-
-#define RX_BUFFER_EMPTY()                   (Console_RxBufferCount()==0)
-#define RX_BUFFER_FULL()                    (Console_RxBufferCount()==CONSOLE_RX_BUFFER_SIZE)
-
-#define ADVANCE_RX_BUFFER_INDEX(Index)      do {(Index) = ((Index) + 1) % CONSOLE_RX_BUFFER_SIZE;} while(0)
-
+#if !RING_SIZE_OK(CONSOLE_TX_BUFFER_SIZE) || !RING_SIZE_OK(CONSOLE_RX_BUFFER_SIZE)
+#error "The console buffer sizes must be a power of 2"
+#endif
 
 
 
@@ -57,20 +41,36 @@ extern uint32_t g_SysClockSpeed;
 
 
 /**
- * Output buffer. Buffer is full if TxReadIndex is one ahead of
- * TxWriteIndex. Buffer is empty if the two indices are the same.
+ * Output buffer. Written by the thread code and drained by the UART ISR.
  */
 static uint8_t TxBuffer[ CONSOLE_TX_BUFFER_SIZE ];
-static volatile uint32_t TxWriteIndex = 0;
-static volatile uint32_t TxReadIndex = 0;
+static sRingBuffer TxRing = RING_BUFFER_INIT( TxBuffer );
 
 /**
- * Input buffer. Buffer is full if TxReadIndex is one ahead of
- * TxWriteIndex. Buffer is empty if the two indices are the same.
+ * Input buffer. Filled by the UART ISR and read by the thread code.
  */
 static uint8_t RxBuffer[ CONSOLE_RX_BUFFER_SIZE ];
-static volatile uint32_t RxWriteIndex = 0;
-static volatile uint32_t RxReadIndex = 0;
+static sRingBuffer RxRing = RING_BUFFER_INIT( RxBuffer );
+
+/**
+ * Set by the UART ISR when it has nothing left to send, so Console_write()
+ * needs to pend the interrupt to get it going again
+ */
+static volatile bool bTxIdle = true;
+
+
+#if (HW_ENABLE_UART_DMA == 1)
+/**
+ * The uDMA channel that drains TxRing
+ */
+static sUartDmaTx ConsoleDmaTx = {
+    CONSOLE_UART_BASE,
+    CONSOLE_UART_DMA_CHANNEL,
+    &TxRing,
+    { 0, 0 },
+    UDMA_PRI_SELECT
+};
+#endif
 
 
 
@@ -86,10 +86,14 @@ void
 Console_FlushTxBuffer( void )
 {
     // The remaining data should be discarded, so temporarily turn off interrupts.
+    // Emptying the ring is the consumer's job so the UART ISR must be kept out.
     bool MasterintStatus = IntMasterDisable();
 
-    // Flush the buffer indices
-    TxReadIndex = TxWriteIndex = 0;
+#if (HW_ENABLE_UART_DMA == 1)
+    UartDma_FlushTx(&ConsoleDmaTx);
+#else
+    Ring_Flush(&TxRing);
+#endif
 
     // If interrupts were enabled when we turned them off, turn them back on again.
     if(!MasterintStatus)
@@ -101,15 +105,8 @@ Console_FlushTxBuffer( void )
 void
 Console_FlushRxBuffer(void)
 {
-    // Temporarily turn off interrupts.
-    bool MasterintStatus = IntMasterDisable();
-
-    // Flush the receive buffer.
-    RxReadIndex = RxWriteIndex = 0;
-
-    // If any interrupts were enabled when we turned them off, turn them back on again.
-    if(!MasterintStatus)
-        IntMasterEnable();
+    // We're the consumer of the receive buffer so this is safe with the UART ISR running
+    Ring_Flush(&RxRing);
 }
 
 
@@ -117,12 +114,7 @@ Console_FlushRxBuffer(void)
 uint32_t
 Console_TxBufferCount( void )
 {
-    uint32_t ui32Write = TxWriteIndex;
-    uint32_t ui32Read  = TxReadIndex;
-
-    return (ui32Write >= ui32Read)
-           ? (ui32Write - ui32Read)
-           : (CONSOLE_TX_BUFFER_SIZE - (ui32Read - ui32Write));
+    return Ring_Count(&TxRing);
 }
 
 
@@ -130,56 +122,51 @@ Console_TxBufferCount( void )
 uint32_t
 Console_RxBufferCount( void )
 {
-    uint32_t ui32Write = RxWriteIndex;
-    uint32_t ui32Read  = RxReadIndex;
-
-    return (ui32Write >= ui32Read)
-           ? (ui32Write - ui32Read)
-           : (CONSOLE_RX_BUFFER_SIZE - (ui32Read - ui32Write));
+    return Ring_Count(&RxRing);
 }
 
 
 
 
 
+#if (HW_ENABLE_UART_DMA == 0)
 
 //*****************************************************************************
 //
 // Take as many bytes from the transmit buffer as we have space for and move
 // them into the UART transmit FIFO.
 //
-// Returns # bytes written to the TX FIFO
-//
 //*****************************************************************************
 
 static void
 PrimeTheTransmitFIFO( void )
 {
-    // Do we have any data to transmit?
-    if(!TX_BUFFER_EMPTY())
+    const uint8_t* pData;
+    uint32_t ui32Len, ui32Sent;
+
+    // The data may be in two parts if the ring has wrapped
+    do
     {
-        // Disable the UART interrupt while we're playing with the buffer indexes
-        IntDisable(CONSOLE_UART_INT);
+        ui32Len = Ring_ReadSpan(&TxRing, 0, &pData);
 
-        // Yes. Take some characters out of the transmit buffer and feed them to the UART transmit FIFO.
-        while(UARTSpaceAvail(CONSOLE_UART_BASE) && !TX_BUFFER_EMPTY())
-        {
-            UARTCharPutNonBlocking(CONSOLE_UART_BASE, TxBuffer[ TxReadIndex ]);
-            ADVANCE_TX_BUFFER_INDEX( TxReadIndex );
-        }
+        for(ui32Sent = 0 ; (ui32Sent < ui32Len) && UARTCharPutNonBlocking(CONSOLE_UART_BASE, pData[ ui32Sent ]) ; ui32Sent++);
 
-        IntEnable(CONSOLE_UART_INT);
+        Ring_Consume(&TxRing, ui32Sent);
     }
+    while(ui32Sent && (ui32Sent == ui32Len));
 }
 
+#endif  // (HW_ENABLE_UART_DMA == 0)
+
 
 
 /*****************************************************************************\
  *
- * UART TX and RX interrupt handler
+ * UART TX and RX interrupt handler. Also pended by Console_write() to start
+ * transmitting.
  *
 \*****************************************************************************/
-static void
+void
 ConsoleUARTIntHandler(void)
 {
     uint32_t int_status;
@@ -190,21 +177,26 @@ ConsoleUARTIntHandler(void)
     UARTIntClear(CONSOLE_UART_BASE, int_status);
 
 
-    // TX FIFO has space available
-    if(int_status & UART_INT_TX)
+#if (HW_ENABLE_UART_DMA == 1)
+    // Free the space used by any completed uDMA transfer and start on the rest of the buffer.
+    // Once nothing is in flight there won't be another UART_INT_DMATX.
+    bTxIdle = !UartDma_ServiceTx(&ConsoleDmaTx);
+#else
+    // Write as many bytes as we can into the transmit FIFO.
+    PrimeTheTransmitFIFO();
+
+    // If the output buffer is now empty, turn off the transmit interrupt.
+    if(Ring_Count(&TxRing) == 0)
     {
-        // If the output buffer is now empty, turn off the transmit interrupt.
-        if(TX_BUFFER_EMPTY())
-        {
-            UARTIntDisable(CONSOLE_UART_BASE, UART_INT_TX);
-        }
-        else
-        {
-            // Write as many bytes as we can into the transmit FIFO.
-            PrimeTheTransmitFIFO();
-            UARTIntEnable(CONSOLE_UART_BASE, UART_INT_TX);
-        }
+        UARTIntDisable(CONSOLE_UART_BASE, UART_INT_TX);
+        bTxIdle = true;
     }
+    else
+    {
+        UARTIntEnable(CONSOLE_UART_BASE, UART_INT_TX);
+        bTxIdle = false;
+    }
+#endif
 
 
     // RX interrupt?
@@ -217,12 +209,7 @@ ConsoleUARTIntHandler(void)
             aChar = UARTCharGetNonBlocking(CONSOLE_UART_BASE);
 
             // If there is space in the receive buffer, save the character otherwise throw it away.
-            if(!RX_BUFFER_FULL())
-            {
-                // Store the new character in the receive buffer
-                RxBuffer[ RxWriteIndex ] = aChar;
-                ADVANCE_RX_BUFFER_INDEX( RxWriteIndex );
-            }
+            Ring_Put(&RxRing, &aChar, 1);
         }
     }
 }
@@ -249,6 +236,10 @@ void Console_InitUART( void )
 
     UARTEnable(CONSOLE_UART_BASE);
 
+#if (HW_ENABLE_UART_DMA == 1)
+    UartDma_InitTx(&ConsoleDmaTx);
+#endif
+
     Console_FlushTxBuffer();
     Console_FlushRxBuffer();
 
@@ -261,8 +252,14 @@ void Console_InitUART( void )
 
     // Don't enable the TX interrupt in the UART till data has been written to the TX FIFO
     UARTIntDisable(CONSOLE_UART_BASE, 0xFFFFFFFF);
+#if (HW_STATIC_VECTORS == 0)
     IntRegister(CONSOLE_UART_INT, ConsoleUARTIntHandler);
+#endif
     UARTIntEnable(CONSOLE_UART_BASE, UART_INT_RX | UART_INT_RT);
+#if (HW_ENABLE_UART_DMA == 1)
+    UARTIntEnable(CONSOLE_UART_BASE, UART_INT_DMATX);
+#endif
+    IntPrioritySet(CONSOLE_UART_INT, CONSOLE_UART_INT_PRIORITY);
     IntEnable(CONSOLE_UART_INT);
 
 }
@@ -283,32 +280,12 @@ void Console_InitUART( void )
 uint32_t
 Console_write(const char *pBuffer, uint32_t len)
 {
-uint32_t nWriteCount = 0;
-uint32_t index;
+    // Write as many characters as we can to the transmit buffer. Any others are discarded.
+    uint32_t nWriteCount = Ring_Write(&TxRing, pBuffer, len);
 
-    for(index=0 ; index < len ; index++)
-    {
-        // Send the character to the UART output.
-        if(!TX_BUFFER_FULL())
-        {
-            TxBuffer[ TxWriteIndex ] = pBuffer[ index ];
-            ADVANCE_TX_BUFFER_INDEX( TxWriteIndex );
-            nWriteCount++;
-        }
-        else
-        {
-            // Buffer is full - discard remaining characters and return.
-            break;
-        }
-    }
-
-
-    // If we have anything in the buffer, make sure that the UART is setup to transmit it.
-    if(!TX_BUFFER_EMPTY())
-    {
-        PrimeTheTransmitFIFO();
-        UARTIntEnable(CONSOLE_UART_BASE, UART_INT_TX);
-    }
+    // Have the UART ISR start transmitting, if it's stopped
+    if(nWriteCount && bTxIdle)
+        IntPendSet(CONSOLE_UART_INT);
 
     // Return the number of characters written.
     return nWriteCount;
@@ -321,13 +298,7 @@ uint32_t index;
 bool
 Console_putchar( uint8_t achar )
 {
-    if (TX_BUFFER_FULL())
-        return false;
-
-    TxBuffer[ TxWriteIndex ] = achar;
-    ADVANCE_TX_BUFFER_INDEX( TxWriteIndex );
-
-    return true;
+    return Ring_Put(&TxRing, &achar, 1);
 }
 
 
@@ -337,10 +308,7 @@ Console_getchar( void )
 {
 uint8_t achar;
 
-    while(RX_BUFFER_EMPTY());
-
-    achar = RxBuffer[ RxReadIndex ];
-    ADVANCE_RX_BUFFER_INDEX( RxReadIndex );
+    while(!Ring_Get(&RxRing, &achar, 1));
 
     return achar;
 }
@@ -355,4 +323,3 @@ Console_puts( char const *pstr )
 
     Console_write("\n\r", 1);
 }
-
@@ -12,6 +12,7 @@
 #include <stdbool.h>
 
 
+// Both must be a power of 2
 #define     CONSOLE_RX_BUFFER_SIZE      1024
 #define     CONSOLE_TX_BUFFER_SIZE      1024
 
@@ -31,6 +32,8 @@
 #define     CONSOLE_UART_TX_PIN_CONFIG    GPIO_PA1_U0TX
 #define     CONSOLE_UART_RX_PIN           GPIO_PIN_0
 #define     CONSOLE_UART_TX_PIN           GPIO_PIN_1
+#define     CONSOLE_UART_DMA_CHANNEL      UDMA_CH9_UART0TX      // If HW_ENABLE_UART_DMA is 1
+#define     CONSOLE_UART_INT_PRIORITY     0xE0                  // The least urgent, see RADIO_INT_PRIORITY in config.h
 
 
 
@@ -45,5 +48,8 @@ bool Console_putchar( uint8_t achar );
 uint8_t Console_getchar( void );
 void Console_puts( const char *pstr );
 
+// For a static vector table, see HW_STATIC_VECTORS in config.h
+void ConsoleUARTIntHandler( void );
+
 
 #endif /* _CONSOLE_H_ */
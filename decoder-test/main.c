@@ -11,8 +11,11 @@
 #include "driverlib/gpio.h"
 #include "driverlib/uart.h"
 
+#include "config.h"
 #include "MSF60decode.h"
+#include "logging.h"
 #include "console.h"
+#include "capture.h"
 
 
 
@@ -20,7 +23,7 @@
 // Indexed by the day-of-week number received from the radio
 const char *days[] = { "Sun", "Mon", "Tue", "Wed", "Thr", "Fri", "Sat" };
 
-// Millisecond timer tick to measure the radio signal timing. Needed by the decoder.
+// Millisecond timer tick to measure the radio signal timing. Needed by the decoder unless HW_ENABLE_CAPTURE_TIMER is set.
 volatile uint32_t    g_msSysTick = 0;
 
 // CPU clock frequency in MHz. Accessed by the decoder library if the debug UART is enabled for logging.
@@ -29,6 +32,12 @@ uint32_t        g_SysClockSpeed;
 // DateTime received from the radio will be copied here by the decoder.
 static sMSFDateTime    msf_DateTime;
 
+#if (MSF_CAPTURE_EDGES > 0)
+// Where the console 'd' command has got to in the capture buffer
+static sCaptureCursor  DumpCursor;
+static bool            bDumping = false;
+#endif
+
 
 
 
@@ -50,13 +59,39 @@ void SysTickIntHandler(void)
 static void InitSystemTick( void )
 {
     SysTickPeriodSet(g_SysClockSpeed / 1000);
+#if (HW_STATIC_VECTORS == 0)
     SysTickIntRegister( SysTickIntHandler );
+#endif
+    IntPrioritySet( FAULT_SYSTICK, SYSTICK_INT_PRIORITY );
     SysTickIntEnable();
     SysTickEnable();
 }
 
 
 
+/**
+ * Write a line of status to the console. While a capture dump is streaming it's written as
+ * a '#' comment, so the dump can still be fed straight to msf-replay.
+ */
+static void
+StatusPuts( const char* pstr )
+{
+#if (MSF_CAPTURE_EDGES > 0)
+char str[ 72 ];
+
+    if (bDumping)
+    {
+        snprintf(str, 72, "# %s", pstr);
+        Console_puts(str);
+        return;
+    }
+#endif
+
+    Console_puts(pstr);
+}
+
+
+
 /**
  *  Print the received date/time to the console formatted as:  DD-MM-YY HH:MM [DOW]
  */
@@ -69,13 +104,13 @@ char buffer[32];
                           msf_DateTime.Hour, msf_DateTime.Minute,
                           days[ msf_DateTime.DOW ] );
 
-    Console_puts(buffer);
+    StatusPuts(buffer);
 }
 
 
 
 /**
- * NOTE:  Called in an interrupt context!
+ * NOTE:  Called from MSF_DispatchEvents(), so in whatever context the main loop or task calling it runs in.
  *
  * In multi-threaded or multi-core environments you can fire off an event or signal from here to
  * wake up a thread when the time updates or SYNC is lost etc.
@@ -87,17 +122,113 @@ EventCallback( eMSFEventType ev )
 char str[ 32 ];
 
     snprintf(str, 32, "Event 0x%04X", ev);
-    Console_puts(str);
+    StatusPuts(str);
+}
+
+
+
+/**
+ * Single key console commands. In a Debug build '0' to '5' turn a logging category
+ * (see eMSFLogType) on or off, and '?' shows which are on. If MSF_CAPTURE_EDGES is set
+ * 'c' starts recording the radio edges, 'x' stops and 'd' dumps them in the msf-replay
+ * trace format. Anything else is ignored.
+ */
+static void
+ConsoleCommand( uint8_t cmd )
+{
+#if defined(DEBUG) || (MSF_CAPTURE_EDGES > 0)
+char str[ 40 ];
+#endif
+
+#if (MSF_CAPTURE_EDGES > 0)
+    switch (cmd)
+    {
+        case 'c':
+            bDumping = false;
+            Capture_Start();
+            Console_puts("Capture started");
+            return;
+
+        case 'x':
+            Capture_Stop();
+            snprintf(str, 40, "Capture stopped, %u edges", (unsigned) Capture_GetCount());
+            StatusPuts(str);
+            return;
+
+        case 'd':
+            Capture_Rewind( &DumpCursor );
+            bDumping = true;
+            snprintf(str, 40, "# MSF capture, %u edges", (unsigned) Capture_GetCount());
+            Console_puts(str);
+            return;
+    }
+#endif
+
+#if defined(DEBUG)
+    if ((cmd >= '0') && (cmd < ('0' + LOG_NUM_TYPES)))
+        LOG_SetMask( LOG_GetMask() ^ LOG_MASK(cmd - '0') );
+    else if (cmd != '?')
+        return;
+
+#if (HW_ENABLE_DEBUG_UART == 1)
+    snprintf(str, 40, "Log mask 0x%02X", (unsigned) LOG_GetMask());
+#else
+    // logging.h compiles the log calls out without the debug UART
+    snprintf(str, 40, "Logging not built in");
+#endif
+    StatusPuts(str);
+#endif
 }
 
 
 
+#if (MSF_CAPTURE_EDGES > 0)
+
+/**
+ * Write the next few captured edges to the console, as many as there's room for in the
+ * transmit buffer. Called every time round the main loop so a long dump doesn't hold up
+ * MSF_Process(). If the capture's still running it follows the new edges as they arrive.
+ */
+static void
+DumpCapture( void )
+{
+char str[ 24 ];
+uint32_t t, level;
+
+    while (bDumping && (Console_TxBufferCount() < (CONSOLE_TX_BUFFER_SIZE - sizeof(str))))
+    {
+        if (Capture_NextEdge( &DumpCursor, &t, &level ))
+        {
+            snprintf(str, 24, "%u %u", (unsigned) t, (unsigned) level);
+            Console_puts(str);
+        }
+        else
+        {
+            if (!Capture_IsRunning())
+            {
+                Console_puts("# end");
+                bDumping = false;
+            }
+            break;
+        }
+    }
+}
+
+#endif
+
+
+
 void main(void)
 {
+    uint32_t nMinutes, nLastMinutes = 0;
+
+#if (HW_ENABLE_CAPTURE_TIMER == 0)
     char msg[ 64 ];
 
     uint32_t msSecondTimer = g_msSysTick;
     uint32_t nSeconds = 0;
+    sMSFTime msf_Time;
+#endif
 
     // First set the CPU clock to 120 MHz
     g_SysClockSpeed = SysCtlClockFreqSet(
@@ -105,10 +236,12 @@ void main(void)
                             120000000 );
 
 
-    InitSystemTick();                       // Start a 1 ms counter
+#if (HW_ENABLE_CAPTURE_TIMER == 0)
+    InitSystemTick();                       // Start a 1 ms counter. Not needed if the decoder timestamps edges in hardware.
+#endif
     Console_InitUART();                     // Initialise the UART connected to the Stellaris virtual COM port on the dev board
 
-    MSF_InitDecoder( &msf_DateTime );       // Initialise the decoder with a ptr to our struct
+    MSF_InitDecoder( NULL );                // Initialise the decoder, the date/time is read with MSF_ReadDateTime()
     MSF_EnableRadio( true );                // Assert the radio enable pin & start decoding the signal
 
     Console_puts("Looping for date/time updates...");
@@ -117,32 +250,54 @@ void main(void)
 
     while (true)
     {
+        // Decode any radio edges queued by the ISR since last time round the loop, then deliver
+        // the events that caused to any handler registered with MSF_EnableEventNotifications()
+        MSF_Process();
+        MSF_DispatchEvents();
 
+#if (HW_ENABLE_CAPTURE_TIMER == 0)
         // Show some status info every second
         if ((g_msSysTick - msSecondTimer) >= 1000)
         {
-            snprintf(msg, 64, "%d seconds, SYNC=%d\n", nSeconds++, MSF_GetSyncState());
-            Console_puts(msg);
+            eMSFTimeQuality quality = MSF_GetTime( &msf_Time );
+
+            snprintf(msg, 64, "%d seconds, SYNC=%d, clock %02u:%02u:%02u.%03u %s\n",
+                              nSeconds++, MSF_GetSyncState(),
+                              (msf_Time.Seconds / 3600) % 24, (msf_Time.Seconds / 60) % 60, msf_Time.Seconds % 60,
+                              msf_Time.Milliseconds, (quality == MSF_TIME_HOLDOVER) ? "holdover" : "");
+            StatusPuts(msg);
             msSecondTimer = g_msSysTick;
         }
+#endif
 
 
         /*
-         * Poll the bDateTimeUpdated flag to check if the time changed.
+         * Poll MSF_ReadDateTime() to check if the time changed. It's safe from any
+         * context, so this could be another task or an ISR.
          * Could instead use event callbacks and get notified that way.
          */
 
 
-        // Display the received date & time if it's valid & has updated.
-        if ((msf_DateTime.bHasValidTime) && (msf_DateTime.bDateTimeUpdated))
+        // Display the received date & time if it has updated.
+        nMinutes = MSF_ReadDateTime( &msf_DateTime );
+        if (nMinutes != nLastMinutes)
         {
             PrintDateTime();
-            msf_DateTime.bDateTimeUpdated = false;
+            nLastMinutes = nMinutes;
         }
 
-        // Read away any unexpected characters received on the console
+        // Handle any commands received on the console
         while (Console_RxBufferCount()>0)
-            Console_getchar();
+            ConsoleCommand( Console_getchar() );
+
+#if (MSF_CAPTURE_EDGES > 0)
+        DumpCapture();
+#endif
+
+        // Nothing else to do till the next interrupt. Edges are timestamped by the ISR so it doesn't
+        // matter how long after the edge MSF_Process() runs. A battery powered client can use
+        // MSF_GetWakeDeadline() to decide when a deeper sleep mode is safe.
+        SysCtlSleep();
 
     }
 }
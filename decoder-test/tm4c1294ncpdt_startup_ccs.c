@@ -23,6 +23,13 @@
 //*****************************************************************************
 
 #include <stdint.h>
+#include <stdbool.h>
+
+#include "inc/hw_ints.h"
+#include "config.h"
+#include "radio.h"
+#include "hardware.h"
+#include "console.h"
 
 //*****************************************************************************
 //
@@ -53,8 +60,52 @@ extern uint32_t __STACK_TOP;
 //
 // External declarations for the interrupt handlers used by the application.
 //
+// With HW_STATIC_VECTORS the drivers don't IntRegister() their handlers, so
+// the vector table stays here in flash and isn't copied to SRAM. The slots
+// below are for the interrupts in config.h and console.h, so if those move
+// the handlers must move with them.
+//
 //*****************************************************************************
-// To be added by user
+extern void SysTickIntHandler(void);
+
+#if (HW_STATIC_VECTORS == 1)
+
+#if (HW_ENABLE_CAPTURE_TIMER == 1) && (RADIO_TIMER_INT != INT_TIMER5B)
+#error "RadioCaptureIntHandler is in the Timer 5B slot, move it to RADIO_TIMER_INT"
+#endif
+#if (HW_ENABLE_CAPTURE_TIMER == 0) && (RADIO_INT_GPIO != INT_GPIOB)
+#error "RadioGpioIntHandler is in the GPIO Port B slot, move it to RADIO_INT_GPIO"
+#endif
+#if (DEBUG_UART_INT != INT_UART6) || (CONSOLE_UART_INT != INT_UART0)
+#error "The UART handlers are in the UART0 and UART6 slots, move them to CONSOLE_UART_INT and DEBUG_UART_INT"
+#endif
+
+#define SYSTICK_VECTOR          SysTickIntHandler
+#define CONSOLE_UART_VECTOR     ConsoleUARTIntHandler
+
+#if (HW_ENABLE_CAPTURE_TIMER == 1)
+#define RADIO_TIMER_VECTOR      RadioCaptureIntHandler
+#define RADIO_GPIO_VECTOR       IntDefaultHandler
+#else
+#define RADIO_TIMER_VECTOR      IntDefaultHandler
+#define RADIO_GPIO_VECTOR       RadioGpioIntHandler
+#endif
+
+#if (HW_ENABLE_DEBUG_UART == 1) && defined(DEBUG)
+#define DEBUG_UART_VECTOR       DebugUARTIntHandler
+#else
+#define DEBUG_UART_VECTOR       IntDefaultHandler
+#endif
+
+#else
+
+#define SYSTICK_VECTOR          IntDefaultHandler
+#define CONSOLE_UART_VECTOR     IntDefaultHandler
+#define RADIO_TIMER_VECTOR      IntDefaultHandler
+#define RADIO_GPIO_VECTOR       IntDefaultHandler
+#define DEBUG_UART_VECTOR       IntDefaultHandler
+
+#endif // HW_STATIC_VECTORS
 
 //*****************************************************************************
 //
@@ -82,13 +133,13 @@ void (* const g_pfnVectors[])(void) =
     IntDefaultHandler,                      // Debug monitor handler
     0,                                      // Reserved
     IntDefaultHandler,                      // The PendSV handler
-    IntDefaultHandler,                      // The SysTick handler
+    SYSTICK_VECTOR,                         // The SysTick handler
     IntDefaultHandler,                      // GPIO Port A
-    IntDefaultHandler,                      // GPIO Port B
+    RADIO_GPIO_VECTOR,                      // GPIO Port B
     IntDefaultHandler,                      // GPIO Port C
     IntDefaultHandler,                      // GPIO Port D
     IntDefaultHandler,                      // GPIO Port E
-    IntDefaultHandler,                      // UART0 Rx and Tx
+    CONSOLE_UART_VECTOR,                    // UART0 Rx and Tx
     IntDefaultHandler,                      // UART1 Rx and Tx
     IntDefaultHandler,                      // SSI0 Rx and Tx
     IntDefaultHandler,                      // I2C0 Master and Slave
@@ -142,14 +193,14 @@ void (* const g_pfnVectors[])(void) =
     IntDefaultHandler,                      // UART3 Rx and Tx
     IntDefaultHandler,                      // UART4 Rx and Tx
     IntDefaultHandler,                      // UART5 Rx and Tx
-    IntDefaultHandler,                      // UART6 Rx and Tx
+    DEBUG_UART_VECTOR,                      // UART6 Rx and Tx
     IntDefaultHandler,                      // UART7 Rx and Tx
     IntDefaultHandler,                      // I2C2 Master and Slave
     IntDefaultHandler,                      // I2C3 Master and Slave
     IntDefaultHandler,                      // Timer 4 subtimer A
     IntDefaultHandler,                      // Timer 4 subtimer B
     IntDefaultHandler,                      // Timer 5 subtimer A
-    IntDefaultHandler,                      // Timer 5 subtimer B
+    RADIO_TIMER_VECTOR,                     // Timer 5 subtimer B
     IntDefaultHandler,                      // FPU
     0,                                      // Reserved
     0,                                      // Reserved
@@ -0,0 +1,296 @@
+
+/********************************************************************************
+ * @file    bench.c
+ * @author  Tony Hanratty
+ * @date    14-Oct-2026
+ *
+ * @brief   Benchmarks the MSF decoder against synthetic signals with noise
+ *
+ * @notes   Usage: msf-bench [-m minutes] [-r runs]
+ *
+ *          Every scenario is run 'runs' times with a different random seed and
+ *          start second, each in a fresh process so the decoder starts from
+ *          reset. For each scenario it reports:
+ *
+ *          - Runs that got a fix and the mean time to the first correct frame
+ *          - Frames decoded out of the frames sent
+ *          - False decodes, frames that passed validation with the wrong time
+ *          - Decoder time per frame sent, all the MSF_Process() calls
+ *
+ *          The decoder mode is set at build time, so build once per mode with
+ *          e.g. -DMSF_DECODER_ENGINE=MSF_ENGINE_SOFT or -DMSF_VOTE_FRAMES=5.
+ *
+ ********************************************************************************/
+
+
+// System includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// Our includes
+#include "config.h"
+#include "MSF60decode.h"
+#include "hostradio.h"
+#include "msfsignal.h"
+
+
+
+// Time of the first second of each run, ms
+#define     T_RUN_START             1000
+
+
+
+typedef struct
+{
+    const char*     pName;
+    sMSFImpairments Imp;                    // JitterMs, GlitchPerMille, DropoutPerMille, FadePeriod, FadeSeconds, OnBiasMs, bInvert
+} sScenario;
+
+STATIC const sScenario Scenarios[] = {
+    { "Clean",              {  0,   0,  0,  0,  0,   0, false } },
+    { "Jitter 10ms",        { 10,   0,  0,  0,  0,   0, false } },
+    { "Jitter 20ms",        { 20,   0,  0,  0,  0,   0, false } },
+    { "Glitches 2%",        {  0,  20,  0,  0,  0,   0, false } },
+    { "Glitches 10%",       {  0, 100,  0,  0,  0,   0, false } },
+    { "Dropouts 2%",        {  0,   0, 20,  0,  0,   0, false } },
+    { "Fade 10s/67s",       {  0,   0,  0, 67, 10,   0, false } },
+    { "Jitter+glitch+drop", { 10,  50, 10,  0,  0,   0, false } },
+
+    // Receiver faults, for MSF_ADAPTIVE_MARGINS and MSF_DETECT_POLARITY
+    { "ON bias 20ms",       { 10,   0,  0,  0,  0,  20, false } },
+    { "ON bias -20ms",      { 10,   0,  0,  0,  0, -20, false } },
+    { "Inverted output",    {  0,   0,  0,  0,  0,   0, true  } }
+};
+
+#define     NUM_SCENARIOS           (sizeof(Scenarios) / sizeof(Scenarios[ 0 ]))
+
+
+
+/**
+ * The results of one run, passed back from the child process
+ */
+typedef struct
+{
+    bool     bFixed;                        // A correct frame was decoded
+    uint32_t FixMs;                         // when, from the start of the signal
+    uint32_t nSent;                         // Complete frames sent
+    uint32_t nDecoded;                      // Frames decoded with the right time
+    uint32_t nFalse;                        // and with the wrong time
+    uint64_t DecoderNs;                     // Time in MSF_Process()
+} sRunResult;
+
+
+
+static sMSFDateTime msf_DateTime;
+static sMSFSignal   Signal;
+static sRunResult   Result;
+static uint32_t     T_Now;
+
+
+
+/**
+ * Check every decoded frame against the last one sent
+ */
+static void
+EventHandler( eMSFEventType ev )
+{
+    if (ev != MSF_EVENT_DATETIME_UPDATED)
+        return;
+
+    MSF_ReadDateTime( &msf_DateTime );
+
+    if (Signal.bHaveLastFrame && MSFSignal_SameMinute( &msf_DateTime, &Signal.LastFrame ))
+    {
+        if (!Result.bFixed)
+        {
+            Result.bFixed = true;
+            Result.FixMs  = T_Now - T_RUN_START;
+        }
+        Result.nDecoded++;
+    }
+    else
+    {
+        Result.nFalse++;
+    }
+}
+
+
+
+/**
+ * Each generated edge goes straight through the decoder
+ */
+static void
+DecodeEdge( uint32_t event_time, uint32_t level, void* pContext )
+{
+    uint32_t start;
+
+    (void) pContext;
+
+    T_Now = event_time;
+    HostRadio_SetTickCount( event_time );
+    MSF_QueueCarrierEdge( 0, level, event_time );
+
+    start = Radio_GetCycleCount();
+    MSF_Process();
+    Result.DecoderNs += Radio_GetCycleCount() - start;
+
+    MSF_DispatchEvents();
+}
+
+
+
+/**
+ * One run of a scenario from reset
+ */
+static void
+Run( const sScenario* pScenario, uint32_t seed, unsigned minutes )
+{
+    sMSFDateTime start;
+    unsigned n;
+
+    memset(&start, 0, sizeof(start));
+    memset(&Result, 0, sizeof(Result));
+
+    // A different date/time every run, starting part way through the date bits of the first frame
+    start.Year   = 10 + (seed % 80);
+    start.Month  = 1 + (seed % 12);
+    start.Day    = 1 + (seed % 28);
+    start.Hour   = seed % 24;
+    start.Minute = (seed * 7) % 60;
+    start.DST    = seed & 1;
+
+    MSF_InitDecoder( NULL );
+    MSF_EnableEventNotifications( EventHandler, MSF_EVENT_DATETIME_UPDATED );
+    MSF_EnableRadio( true );
+
+    MSFSignal_Init( &Signal, &start, 17 + ((seed * 13) % 43), T_RUN_START, &pScenario->Imp, seed );
+
+    for (n = 0 ; n <= minutes ; n++)
+        MSFSignal_SendMinute( &Signal, DecodeEdge, NULL );
+
+    // The minute marker that completes the last frame, and the edge that ends it
+    MSFSignal_SendSecond( &Signal, DecodeEdge, NULL );
+    MSFSignal_SendSecond( &Signal, DecodeEdge, NULL );
+
+    // The first frame was only partly sent
+    Result.nSent = minutes;
+}
+
+
+
+/**
+ * Run in a child process, so every run starts with the decoder's statics reset
+ */
+static bool
+RunFresh( const sScenario* pScenario, uint32_t seed, unsigned minutes, sRunResult* pResult )
+{
+    int   fd[ 2 ];
+    int   status;
+    pid_t pid;
+    bool  bOk;
+
+    if (pipe(fd) != 0)
+        return false;
+
+    pid = fork();
+    if (pid < 0)
+        return false;
+
+    if (pid == 0)
+    {
+        close(fd[ 0 ]);
+        Run( pScenario, seed, minutes );
+        _exit((write(fd[ 1 ], &Result, sizeof(Result)) == sizeof(Result)) ? 0 : 1);
+    }
+
+    close(fd[ 1 ]);
+    bOk = (read(fd[ 0 ], pResult, sizeof(sRunResult)) == sizeof(sRunResult));
+    close(fd[ 0 ]);
+
+    waitpid(pid, &status, 0);
+
+    return bOk && WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+}
+
+
+
+static void
+Usage( void )
+{
+    fprintf(stderr, "Usage: msf-bench [-m minutes] [-r runs]\n");
+    exit(1);
+}
+
+
+
+int
+main( int argc, char* argv[] )
+{
+    unsigned long minutes = 30, runs = 8;
+    sRunResult r;
+    uint32_t nFixed, nSent, nDecoded, nFalse;
+    uint64_t FixMs, DecoderNs;
+    unsigned s, run;
+    int i;
+
+    for (i = 1 ; i < argc ; i++)
+    {
+        if ((strcmp(argv[ i ], "-m") == 0) && (i + 1 < argc))
+            minutes = strtoul(argv[ ++i ], NULL, 0);
+        else if ((strcmp(argv[ i ], "-r") == 0) && (i + 1 < argc))
+            runs = strtoul(argv[ ++i ], NULL, 0);
+        else
+            Usage();
+    }
+
+    if ((minutes == 0) || (runs == 0))
+        Usage();
+
+    printf("%s engine, %u frame voting, %lu runs of %lu minutes\n\n",
+           (MSF_DECODER_ENGINE == MSF_ENGINE_SOFT) ? "Soft" : "Hard", (unsigned) MSF_VOTE_FRAMES, runs, minutes);
+    printf("%-20s %7s %10s %14s %8s %10s\n", "Scenario", "Fixed", "TTFF (s)", "Decoded", "False", "ns/frame");
+
+    for (s = 0 ; s < NUM_SCENARIOS ; s++)
+    {
+        nFixed = nSent = nDecoded = nFalse = 0;
+        FixMs = DecoderNs = 0;
+
+        for (run = 0 ; run < runs ; run++)
+        {
+            if (!RunFresh( &Scenarios[ s ], 1 + run, minutes, &r ))
+            {
+                fprintf(stderr, "%s run %u failed\n", Scenarios[ s ].pName, run);
+                return 1;
+            }
+
+            if (r.bFixed)
+            {
+                nFixed++;
+                FixMs += r.FixMs;
+            }
+
+            nSent     += r.nSent;
+            nDecoded  += r.nDecoded;
+            nFalse    += r.nFalse;
+            DecoderNs += r.DecoderNs;
+        }
+
+        printf("%-20s %3" PRIu32 "/%-3lu ", Scenarios[ s ].pName, nFixed, runs);
+
+        if (nFixed)
+            printf("%10.1f ", (double) FixMs / nFixed / 1000.0);
+        else
+            printf("%10s ", "-");
+
+        printf("%6" PRIu32 "/%-6" PRIu32 " %8" PRIu32 " %10" PRIu64 "\n",
+               nDecoded, nSent, nFalse, DecoderNs / nSent);
+    }
+
+    return 0;
+}
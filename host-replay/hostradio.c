@@ -0,0 +1,145 @@
+
+/********************************************************************************
+ * @file    hostradio.c
+ * @author  Tony Hanratty
+ * @date    14-Oct-2026
+ *
+ * @brief   PC implementation of the decoder's radio interface
+ *
+ * @notes   Lets MSF60decode.c build and run natively, e.g. for the replay tool.
+ *          Time is whatever the caller says it is, so recorded edges can be
+ *          fed in as fast as the decoder can take them. Ticks are milliseconds
+ *          and the "cycle" count used by MSF_GetStats() is in nanoseconds.
+ *
+ ********************************************************************************/
+
+
+// System includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+// Our includes
+#include "config.h"
+
+// This file's include
+#include "hostradio.h"
+
+
+
+STATIC uint32_t HostTickCount = 0;
+STATIC bool     bHostRadioEnabled = false;
+
+
+
+/*******************************************************************
+* NAME
+*       HostRadio_SetTickCount()
+*
+* DESCRIPTION
+*       Set the time returned by Radio_GetTickCount()
+*
+* PARAMETERS
+*       uint32_t    ticks       The time now, in milliseconds
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*       Call with each edge's timestamp before queueing it, so the decoder's
+*       clock moves on with the recording.
+*
+********************************************************************/
+void
+HostRadio_SetTickCount( uint32_t ticks )
+{
+    HostTickCount = ticks;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       HostRadio_IsEnabled()
+*
+* DESCRIPTION
+*       Check whether the decoder has enabled the radio
+*
+* PARAMETERS
+*       None
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       bool        The last state passed to Radio_Enable()
+*
+* NOTES
+*
+********************************************************************/
+bool
+HostRadio_IsEnabled( void )
+{
+    return bHostRadioEnabled;
+}
+
+
+
+/**
+ * The radio interface, see radio.c for the TM4C1294 version
+ */
+void
+Radio_Init( void )
+{
+    HostTickCount = 0;
+    bHostRadioEnabled = false;
+}
+
+
+void
+Radio_Enable( bool state )
+{
+    bHostRadioEnabled = state;
+}
+
+
+uint32_t
+Radio_GetTickCount( void )
+{
+    return HostTickCount;
+}
+
+
+uint32_t
+Radio_GetTicksPerMs( void )
+{
+    return 1;
+}
+
+
+uint32_t
+Radio_GetCycleCount( void )
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t)((now.tv_sec * 1000000000ULL) + now.tv_nsec);
+}
+
+
+uint32_t
+Radio_IntDisable( void )
+{
+    return 0;
+}
+
+
+void
+Radio_IntRestore( uint32_t mask )
+{
+    (void) mask;
+}
@@ -0,0 +1,31 @@
+/********************************************************************************
+ * @file    hostradio.h
+ * @author  Tony Hanratty
+ * @date    14-Oct-2026
+ *
+ * @brief   PC implementation of the decoder's radio interface
+ ********************************************************************************/
+
+#ifndef _HOSTRADIO_H_
+#define _HOSTRADIO_H_
+
+
+// System includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// Our includes
+#include "radio.h"
+
+
+
+/**
+ * There's no radio ISR on a PC. The tool driving the decoder sets the time
+ * of each edge before passing it to MSF_QueueCarrierEdge().
+ */
+void HostRadio_SetTickCount( uint32_t ticks );
+bool HostRadio_IsEnabled( void );
+
+
+
+#endif  // _HOSTRADIO_H_
@@ -0,0 +1,81 @@
+#!/bin/sh
+#
+################################################################################
+# @file    msf-footprint.sh
+# @author  Tony Hanratty
+# @date    14-Oct-2026
+#
+# @brief   Flash & RAM budget of each decoder option
+#
+# @notes   Usage: msf-footprint.sh [extra compiler flags]
+#
+#          Builds the decoder (MSF60decode.c, ringbuf.c and capture.c) for the
+#          target with MSF_PROFILE_MINIMAL, then again with each option turned
+#          on by itself, and prints the flash (text + data) and RAM (data + bss)
+#          of each build and what the option adds to the minimal profile.
+#
+#          CC, CFLAGS and SIZE pick the toolchain, by default arm-none-eabi-gcc
+#          for a Cortex-M0 at -Os. The objects aren't linked, so compiler helpers
+#          like the 64 bit divide aren't counted. The last lines list what the
+#          minimal build needs from outside the decoder, the symbols the objects
+#          use that none of them define. That should be the radio interface in
+#          radio.h, and memset() and memcpy() unless the compiler inlined them.
+#
+################################################################################
+
+CC=${CC:-arm-none-eabi-gcc}
+SIZE=${SIZE:-arm-none-eabi-size}
+NM=${NM:-arm-none-eabi-nm}
+CFLAGS=${CFLAGS:--mcpu=cortex-m0 -mthumb -Os -ffunction-sections -fdata-sections}
+
+SRC=$(dirname "$0")/../MSF60decode
+OUT=${TMPDIR:-/tmp}/msf-footprint.$$
+mkdir -p "$OUT" || exit 1
+trap 'rm -rf "$OUT"' EXIT
+
+# Build with the minimal profile plus $1, print "flash ram"
+build()
+{
+    for f in MSF60decode ringbuf capture; do
+        $CC $CFLAGS -std=gnu99 -DMSF_PROFILE=MSF_PROFILE_MINIMAL $EXTRA $1 -I"$SRC" \
+            -c "$SRC/$f.c" -o "$OUT/$f.o" || return 1
+    done
+    $SIZE "$OUT"/*.o | awk 'NR > 1 { text += $1; data += $2; bss += $3 } END { print text + data, data + bss }'
+}
+
+EXTRA="$*"
+
+set -- $(build "") || exit 1
+MIN_FLASH=$1
+MIN_RAM=$2
+
+printf "%-24s %8s %8s %8s %8s\n" "Option" "Flash" "RAM" "+Flash" "+RAM"
+printf "%-24s %8u %8u\n" "Minimal profile" $MIN_FLASH $MIN_RAM
+
+while IFS='|' read -r name flags; do
+    sizes=$(build "$flags") || exit 1
+    set -- $sizes
+    printf "%-24s %8u %8u %+8d %+8d\n" "$name" $1 $2 $(($1 - MIN_FLASH)) $(($2 - MIN_RAM))
+done <<EOF
+Soft engine|-DMSF_DECODER_ENGINE=MSF_ENGINE_SOFT
+Frame voting (5)|-DMSF_VOTE_FRAMES=5
+Statistics|-DMSF_ENABLE_STATS=1
+Signal quality|-DMSF_ENABLE_QUALITY=1
+Width calibration|-DMSF_ADAPTIVE_MARGINS=1
+Polarity detection|-DMSF_DETECT_POLARITY=1
+Drift measurement|-DMSF_MEASURE_DRIFT=1
+Event queue (8)|-DMSF_EVENT_QUEUE_SIZE=8
+Edge queue (16)|-DMSF_EDGE_QUEUE_SIZE=16
+Edge capture (1024)|-DMSF_CAPTURE_EDGES=1024
+Unpacked state|-DMSF_PACKED_STATE=0
+No glitch filter|-DMSF_GLITCH_FILTER_MS=0
+Second receiver|-DMSF_NUM_RECEIVERS=2
+Full profile|-UMSF_PROFILE
+EOF
+
+build "" >/dev/null || exit 1
+echo
+echo "Minimal profile needs:" $($NM "$OUT"/*.o | awk '
+    $1 == "U"   { used[ $2 ] = 1 }
+    NF == 3     { defined[ $3 ] = 1 }
+    END         { for (s in used) if (!(s in defined)) print s }' | sort)
@@ -0,0 +1,159 @@
+
+/********************************************************************************
+ * @file    msfgen.c
+ * @author  Tony Hanratty
+ * @date    14-Oct-2026
+ *
+ * @brief   Writes a synthetic MSF60 edge trace for msf-replay
+ *
+ * @notes   Usage: msf-gen [options] > trace.txt
+ *
+ *          -t YY-MM-DD,hh:mm   Date/time in the first frame, default 24-06-15,12:00
+ *          -b                  British Summer Time, B58 set
+ *          -u tenths           DUT1 in tenths of a second, -8 to 8, default 0
+ *          -n minutes          Minutes of signal, default 60
+ *          -o second           Second of the first frame to start at, default 0
+ *          -j ms               Move each edge by up to +/- this
+ *          -g per_mille        Chance of a glitch in each 100ms
+ *          -d per_mille        Chance of losing each second
+ *          -f period,seconds   Fade to noise for 'seconds' every 'period'
+ *          -e ms               Delay each CARRIER_ON edge by this, -ve for early
+ *          -i                  Invert the output, as some receivers do
+ *          -s seed             Random number seed, default 1
+ *
+ ********************************************************************************/
+
+
+// System includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+// Our includes
+#include "config.h"
+#include "msfsignal.h"
+
+
+
+// Time of the first second in the trace, ms
+#define     T_TRACE_START           1000
+
+
+
+/**
+ * Write each edge as a trace line
+ */
+static void
+WriteEdge( uint32_t event_time, uint32_t level, void* pContext )
+{
+    fprintf((FILE*) pContext, "%" PRIu32 " %" PRIu32 "\n", event_time, level);
+}
+
+
+
+static void
+Usage( void )
+{
+    fprintf(stderr, "Usage: msf-gen [-t YY-MM-DD,hh:mm] [-b] [-u tenths] [-n minutes] [-o second] [-j ms]\n"
+                    "               [-g per_mille] [-d per_mille] [-f period,seconds] [-e ms] [-i] [-s seed]\n");
+    exit(1);
+}
+
+
+
+int
+main( int argc, char* argv[] )
+{
+    sMSFDateTime    start;
+    sMSFImpairments imp;
+    sMSFSignal      sig;
+    unsigned y = 24, mo = 6, d = 15, h = 12, mi = 0;
+    unsigned long minutes = 60, offset = 0, seed = 1;
+    unsigned long n;
+    long dut1;
+    const char* pArg;
+    int i;
+
+    memset(&start, 0, sizeof(start));
+    memset(&imp, 0, sizeof(imp));
+
+    for (i = 1 ; i < argc ; i++)
+    {
+        if (argv[ i ][ 0 ] != '-')
+            Usage();
+
+        if (strcmp(argv[ i ], "-b") == 0)
+        {
+            start.DST = 1;
+            continue;
+        }
+
+        if (strcmp(argv[ i ], "-i") == 0)
+        {
+            imp.bInvert = true;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+            Usage();
+        pArg = argv[ ++i ];
+
+        switch (argv[ i - 1 ][ 1 ])
+        {
+            case 't':
+                if ((sscanf(pArg, "%u-%u-%u,%u:%u", &y, &mo, &d, &h, &mi) != 5) ||
+                    (y > 99) || (mo < 1) || (mo > 12) || (d < 1) || (d > 31) || (h > 23) || (mi > 59))
+                    Usage();
+                break;
+
+            case 'u':
+                dut1 = strtol(pArg, NULL, 0);
+                if ((dut1 < -8) || (dut1 > 8))
+                    Usage();
+                start.DUT1 = (int8_t) dut1;
+                break;
+
+            case 'n':   minutes = strtoul(pArg, NULL, 0);               break;
+            case 'o':   offset = strtoul(pArg, NULL, 0) % 60;           break;
+            case 'j':   imp.JitterMs = strtoul(pArg, NULL, 0);          break;
+            case 'g':   imp.GlitchPerMille = strtoul(pArg, NULL, 0);    break;
+            case 'd':   imp.DropoutPerMille = strtoul(pArg, NULL, 0);   break;
+            case 's':   seed = strtoul(pArg, NULL, 0);                  break;
+            case 'e':   imp.OnBiasMs = (int32_t) strtol(pArg, NULL, 0); break;
+
+            case 'f':
+                if (sscanf(pArg, "%" SCNu32 ",%" SCNu32, &imp.FadePeriod, &imp.FadeSeconds) != 2)
+                    Usage();
+                break;
+
+            default:
+                Usage();
+        }
+    }
+
+    start.Year   = y;
+    start.Month  = mo;
+    start.Day    = d;
+    start.Hour   = h;
+    start.Minute = mi;
+
+    MSFSignal_Init( &sig, &start, offset, T_TRACE_START, &imp, seed );
+
+    printf("# msf-gen %02u-%02u-%02u,%02u:%02u %s DUT1 %+d, %lu minutes from second %lu\n",
+           y, mo, d, h, mi, (start.DST) ? "BST" : "GMT", start.DUT1, minutes, offset);
+    printf("# jitter %" PRIu32 " ms, glitches %" PRIu32 "/1000, dropouts %" PRIu32 "/1000, fade %" PRIu32 "s every %" PRIu32 "s, seed %lu\n",
+           imp.JitterMs, imp.GlitchPerMille, imp.DropoutPerMille, imp.FadeSeconds, imp.FadePeriod, seed);
+    printf("# CARRIER_ON edges %+" PRId32 " ms, %s output\n", imp.OnBiasMs, (imp.bInvert) ? "inverted" : "normal");
+
+    for (n = 0 ; n < minutes ; n++)
+        MSFSignal_SendMinute( &sig, WriteEdge, stdout );
+
+    // The minute marker that completes the last frame, and the edge that ends it
+    MSFSignal_SendSecond( &sig, WriteEdge, stdout );
+    MSFSignal_SendSecond( &sig, WriteEdge, stdout );
+
+    return 0;
+}
@@ -0,0 +1,453 @@
+
+/********************************************************************************
+ * @file    msfsignal.c
+ * @author  Tony Hanratty
+ * @date    14-Oct-2026
+ *
+ * @brief   Synthetic MSF60 signal generator with noise injection
+ *
+ * @notes   Encodes a date/time as the MSF A & B bits, with the A52 to A59
+ *          marker and the B54 to B57 parity bits, and turns them into radio
+ *          edges one second at a time.
+ *
+ *          Each second is drawn into a millisecond sample buffer of the data
+ *          pin level, then the dropouts, fades & glitches are drawn over it.
+ *          The edges are wherever the level changes, each moved by the jitter.
+ *          Then the receiver's own faults are added, a delay on CARRIER_ON
+ *          edges and an inverted output.
+ *          The random numbers are from a seeded xorshift so runs repeat exactly.
+ *
+ ********************************************************************************/
+
+
+// System includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Our includes
+#include "config.h"
+
+// This file's include
+#include "msfsignal.h"
+
+
+
+// Radio data pin levels, the receiver inverts the carrier
+#define     PIN_CARRIER_ON          0
+#define     PIN_CARRIER_OFF         1
+
+#define     SECOND_MS               1000
+
+// Glitch lengths, and the lengths of the noise bursts during a fade
+#define     GLITCH_MIN_MS           2
+#define     GLITCH_MAX_MS           10
+#define     FADE_MIN_MS             5
+#define     FADE_MAX_MS             100
+
+// Bits A52 through A59 are always 01111110
+#define     FRAME_MARKER            0x7E
+
+
+
+// Days in each month, not counting Feb 29th
+STATIC const uint8_t DaysInMonth[ 12 ] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+
+
+/**
+ * xorshift32, never returns 0 from a non zero seed
+ */
+STATIC uint32_t
+Random( sMSFSignal* pSig )
+{
+    uint32_t x = pSig->Random;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return pSig->Random = x;
+}
+
+
+
+/**
+ * Random number from..to inclusive
+ */
+STATIC uint32_t
+RandomRange( sMSFSignal* pSig, uint32_t from, uint32_t to )
+{
+    return from + (Random(pSig) % (to - from + 1));
+}
+
+
+
+/**
+ * true with a chance of 'per_mille' in 1000
+ */
+STATIC bool
+RandomChance( sMSFSignal* pSig, uint32_t per_mille )
+{
+    return (per_mille) && ((Random(pSig) % 1000) < per_mille);
+}
+
+
+
+/**
+ * Set bits from..to of a channel to the binary 'value', MSB first
+ */
+STATIC void
+PutField( uint8_t* pBits, unsigned from, unsigned to, uint32_t value )
+{
+    unsigned bit;
+
+    for (bit = to ; bit >= from ; bit--)
+    {
+        pBits[ bit ] = value & 1;
+        value >>= 1;
+    }
+}
+
+
+
+/**
+ * Convert 0-99 to BCD
+ */
+STATIC uint32_t
+ToBCD( uint32_t value )
+{
+    return ((value / 10) << 4) | (value % 10);
+}
+
+
+
+/**
+ * Get the parity bit that makes bits from..to odd parity
+ */
+STATIC uint8_t
+OddParity( const uint8_t* pBits, unsigned from, unsigned to )
+{
+    unsigned bit, ones = 0;
+
+    for (bit = from ; bit <= to ; bit++)
+        ones += pBits[ bit ];
+
+    return (ones & 1) ? 0 : 1;
+}
+
+
+
+/**
+ * Fill in the A & B bits for the current DateTime
+ */
+STATIC void
+EncodeFrame( sMSFSignal* pSig )
+{
+    const sMSFDateTime* pDT = &pSig->DateTime;
+    unsigned bit, tenths;
+
+    memset(pSig->A, 0, sizeof(pSig->A));
+    memset(pSig->B, 0, sizeof(pSig->B));
+
+    PutField( pSig->A, 17, 24, ToBCD( pDT->Year ));
+    PutField( pSig->A, 25, 29, ToBCD( pDT->Month ));
+    PutField( pSig->A, 30, 35, ToBCD( pDT->Day ));
+    PutField( pSig->A, 36, 38, pDT->DOW );
+    PutField( pSig->A, 39, 44, ToBCD( pDT->Hour ));
+    PutField( pSig->A, 45, 51, ToBCD( pDT->Minute ));
+    PutField( pSig->A, 52, 59, FRAME_MARKER );
+
+    pSig->B[ 54 ] = OddParity( pSig->A, 17, 24 );
+    pSig->B[ 55 ] = OddParity( pSig->A, 25, 35 );
+    pSig->B[ 56 ] = OddParity( pSig->A, 36, 38 );
+    pSig->B[ 57 ] = OddParity( pSig->A, 39, 51 );
+    pSig->B[ 58 ] = pDT->DST;
+
+    // DUT1 fills from B1 when positive, from B9 when negative
+    tenths = (unsigned)((pDT->DUT1 < 0) ? -pDT->DUT1 : pDT->DUT1);
+    for (bit = 0 ; (bit < tenths) && (bit < 8) ; bit++)
+        pSig->B[ ((pDT->DUT1 < 0) ? 9 : 1) + bit ] = 1;
+
+    pSig->B[ 53 ] = pDT->DSTWarning;
+}
+
+
+
+/**
+ * Work out the day of the week, 1st Jan 2000 was a Saturday
+ */
+STATIC uint8_t
+DayOfWeek( const sMSFDateTime* pDT )
+{
+    uint32_t days = (pDT->Year * 365) + ((pDT->Year + 3) / 4) + (pDT->Day - 1);
+    unsigned month;
+
+    for (month = 1 ; (month < pDT->Month) && (month <= 12) ; month++)
+        days += DaysInMonth[ month - 1 ] + (((month == 2) && ((pDT->Year % 4) == 0)) ? 1 : 0);
+
+    return (uint8_t)((days + 6) % 7);
+}
+
+
+
+/**
+ * Move DateTime on by one minute
+ */
+STATIC void
+NextMinute( sMSFDateTime* pDT )
+{
+    uint8_t days;
+
+    if (++pDT->Minute < 60)
+        return;
+    pDT->Minute = 0;
+
+    if (++pDT->Hour < 24)
+        return;
+    pDT->Hour = 0;
+
+    pDT->DOW = (pDT->DOW + 1) % 7;
+
+    // 2000 to 2099, every 4th year is a leap year
+    days = DaysInMonth[ (pDT->Month - 1) % 12 ] + (((pDT->Month == 2) && ((pDT->Year % 4) == 0)) ? 1 : 0);
+
+    if (++pDT->Day <= days)
+        return;
+    pDT->Day = 1;
+
+    if (++pDT->Month <= 12)
+        return;
+    pDT->Month = 1;
+
+    pDT->Year = (pDT->Year + 1) % 100;
+}
+
+
+
+/*******************************************************************
+* NAME
+*       MSFSignal_Init()
+*
+* DESCRIPTION
+*       Start generating a signal
+*
+* PARAMETERS
+*       pSig            Generator state
+*       pStart          Date/time in the first frame. The day of the
+*                       week is worked out from the date.
+*       start_second    Second of the first frame the signal starts at, 0
+*                       to start at its minute marker
+*       T_Start         Time of the start of that second, ms
+*       pImp            Impairments, or NULL for a perfect signal
+*       seed            Random number seed, any value
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*       The frames follow the MSF convention, each one is the date/time at
+*       the minute marker that ends it.
+*
+********************************************************************/
+void
+MSFSignal_Init( sMSFSignal* pSig, const sMSFDateTime* pStart, unsigned start_second,
+                uint32_t T_Start, const sMSFImpairments* pImp, uint32_t seed )
+{
+    memset(pSig, 0, sizeof(sMSFSignal));
+
+    pSig->DateTime = *pStart;
+    pSig->DateTime.bHasValidTime = true;
+    pSig->DateTime.DOW = DayOfWeek( pStart );
+
+    if (pImp)
+        pSig->Imp = *pImp;
+
+    pSig->T_Second   = T_Start;
+    pSig->T_LastEdge = T_Start;
+    pSig->Second     = start_second % 60;
+    pSig->Level      = PIN_CARRIER_ON;
+    pSig->Random     = (seed) ? seed : 1;
+
+    EncodeFrame( pSig );
+}
+
+
+
+/*******************************************************************
+* NAME
+*       MSFSignal_SendSecond()
+*
+* DESCRIPTION
+*       Generate the edges for the next second of signal
+*
+* PARAMETERS
+*       pSig            Generator state
+*       pfEdge          Called for each edge, in time order
+*       pContext        Passed to pfEdge
+*
+* OUTPUTS
+*       After second 59 LastFrame is set and DateTime moves on a minute
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*
+********************************************************************/
+void
+MSFSignal_SendSecond( sMSFSignal* pSig, MSF_SIGNAL_EDGE pfEdge, void* pContext )
+{
+    uint8_t  level[ SECOND_MS ];
+    unsigned ms, start, end, len;
+    int32_t  jitter;
+    uint32_t t;
+    bool     bFlip;
+
+    // The signal as broadcast. Every second starts with 100ms OFF, the minute marker with 500ms.
+    memset(level, PIN_CARRIER_ON, sizeof(level));
+
+    if (pSig->Second == 0)
+    {
+        memset(&level[ 0 ], PIN_CARRIER_OFF, 500);
+    }
+    else
+    {
+        memset(&level[ 0 ], PIN_CARRIER_OFF, 100);
+        if (pSig->A[ pSig->Second ])
+            memset(&level[ 100 ], PIN_CARRIER_OFF, 100);
+        if (pSig->B[ pSig->Second ])
+            memset(&level[ 200 ], PIN_CARRIER_OFF, 100);
+    }
+
+    // Lost altogether
+    if (RandomChance( pSig, pSig->Imp.DropoutPerMille ))
+        memset(level, PIN_CARRIER_OFF, sizeof(level));
+
+    // Faded to random bursts of noise
+    if ((pSig->Imp.FadePeriod) && ((pSig->nSeconds % pSig->Imp.FadePeriod) < pSig->Imp.FadeSeconds))
+    {
+        for (ms = 0 ; ms < SECOND_MS ; ms = end)
+        {
+            end   = ms + RandomRange( pSig, FADE_MIN_MS, FADE_MAX_MS );
+            bFlip = RandomChance( pSig, 500 );
+
+            for ( ; (ms < end) && (ms < SECOND_MS) ; ms++)
+                if (bFlip)
+                    level[ ms ] ^= 1;
+        }
+    }
+
+    // Short glitches
+    for (ms = 0 ; ms < SECOND_MS ; ms += 100)
+    {
+        if (RandomChance( pSig, pSig->Imp.GlitchPerMille ))
+        {
+            len   = RandomRange( pSig, GLITCH_MIN_MS, GLITCH_MAX_MS );
+            start = ms + RandomRange( pSig, 0, 100 - len );
+
+            for (end = start + len ; start < end ; start++)
+                level[ start ] ^= 1;
+        }
+    }
+
+    // An edge wherever the level changes
+    for (ms = 0 ; ms < SECOND_MS ; ms++)
+    {
+        if (level[ ms ] == pSig->Level)
+            continue;
+
+        pSig->Level = level[ ms ];
+
+        jitter = (pSig->Imp.JitterMs) ? (int32_t) RandomRange( pSig, 0, 2 * pSig->Imp.JitterMs ) - (int32_t) pSig->Imp.JitterMs : 0;
+        t = pSig->T_Second + ms + jitter;
+
+        if (pSig->Level == PIN_CARRIER_ON)
+            t += pSig->Imp.OnBiasMs;
+
+        // Jitter and bias can't reorder the edges
+        if ((int32_t)(t - pSig->T_LastEdge) <= 0)
+            t = pSig->T_LastEdge + 1;
+
+        pSig->T_LastEdge = t;
+        pfEdge( t, (pSig->Imp.bInvert) ? pSig->Level ^ 1 : pSig->Level, pContext );
+    }
+
+    pSig->T_Second += SECOND_MS;
+    pSig->nSeconds++;
+
+    if (++pSig->Second == 60)
+    {
+        pSig->LastFrame      = pSig->DateTime;
+        pSig->bHaveLastFrame = true;
+        pSig->Second         = 0;
+
+        NextMinute( &pSig->DateTime );
+        EncodeFrame( pSig );
+    }
+}
+
+
+
+/*******************************************************************
+* NAME
+*       MSFSignal_SendMinute()
+*
+* DESCRIPTION
+*       Generate the edges up to the start of the next minute marker
+*
+* PARAMETERS
+*       pSig            Generator state
+*       pfEdge          Called for each edge, in time order
+*       pContext        Passed to pfEdge
+*
+* OUTPUTS
+*       LastFrame is the frame just completed
+*
+* RETURNS
+*       Nothing
+*
+* NOTES
+*       The decoder only sees a frame is complete once the next minute
+*       marker has ended, so send two more seconds after the last minute.
+*
+********************************************************************/
+void
+MSFSignal_SendMinute( sMSFSignal* pSig, MSF_SIGNAL_EDGE pfEdge, void* pContext )
+{
+    do {
+        MSFSignal_SendSecond( pSig, pfEdge, pContext );
+    } while (pSig->Second != 0);
+}
+
+
+
+/*******************************************************************
+* NAME
+*       MSFSignal_SameMinute()
+*
+* DESCRIPTION
+*       Compare two date/times
+*
+* PARAMETERS
+*       pA, pB          The date/times
+*
+* OUTPUTS
+*       None
+*
+* RETURNS
+*       bool            true if every field the MSF frame carries matches
+*
+* NOTES
+*
+********************************************************************/
+bool
+MSFSignal_SameMinute( const sMSFDateTime* pA, const sMSFDateTime* pB )
+{
+    return (pA->Year == pB->Year) && (pA->Month == pB->Month) && (pA->Day == pB->Day) &&
+           (pA->DOW == pB->DOW) && (pA->Hour == pB->Hour) && (pA->Minute == pB->Minute) &&
+           (pA->DST == pB->DST);
+}
@@ -0,0 +1,77 @@
+/********************************************************************************
+ * @file    msfsignal.h
+ * @author  Tony Hanratty
+ * @date    14-Oct-2026
+ *
+ * @brief   Synthetic MSF60 signal generator with noise injection
+ ********************************************************************************/
+
+#ifndef _MSFSIGNAL_H_
+#define _MSFSIGNAL_H_
+
+
+// System includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// Our includes
+#include "MSF60decode.h"
+
+
+
+/**
+ * What goes wrong with the signal. All zero is a perfect signal.
+ */
+typedef struct
+{
+    uint32_t JitterMs;                      // Each edge moves by up to +/- this many ms
+    uint32_t GlitchPerMille;                // Chance in 1000 of a 2-10ms glitch in each 100ms of signal
+    uint32_t DropoutPerMille;               // Chance in 1000 of losing each second, the carrier is OFF throughout
+    uint32_t FadePeriod;                    // Every FadePeriod seconds the signal fades to noise
+    uint32_t FadeSeconds;                   // for this many seconds. 0 for no fades.
+    int32_t  OnBiasMs;                      // The receiver reports CARRIER_ON edges this much late, -ve for early
+    bool     bInvert;                       // The receiver's output is the other way up, 0 for CARRIER_OFF
+} sMSFImpairments;
+
+
+
+/**
+ * Called for every edge generated. 'level' is the radio data pin level after
+ * the edge, 1 for CARRIER_OFF, as the radio ISR would read it.
+ */
+typedef void (*MSF_SIGNAL_EDGE)( uint32_t event_time, uint32_t level, void* pContext );
+
+
+
+/**
+ * Generator state. DateTime and LastFrame can be read, the rest is private.
+ */
+typedef struct
+{
+    sMSFDateTime    DateTime;               // Encoded in the frame being sent
+    sMSFDateTime    LastFrame;              // The last frame sent in full
+    bool            bHaveLastFrame;         // LastFrame is valid
+    uint32_t        nSeconds;               // Seconds sent
+
+    // Private
+    sMSFImpairments Imp;
+    uint32_t        T_Second;               // Start of the next second, ms
+    unsigned        Second;                 // Next second of the frame, 0 is the minute marker
+    uint32_t        Level;                  // Pin level at the end of the last second
+    uint32_t        T_LastEdge;
+    uint32_t        Random;
+    uint8_t         A[ 60 ];
+    uint8_t         B[ 60 ];
+} sMSFSignal;
+
+
+
+void MSFSignal_Init( sMSFSignal* pSig, const sMSFDateTime* pStart, unsigned start_second,
+                     uint32_t T_Start, const sMSFImpairments* pImp, uint32_t seed );
+void MSFSignal_SendSecond( sMSFSignal* pSig, MSF_SIGNAL_EDGE pfEdge, void* pContext );
+void MSFSignal_SendMinute( sMSFSignal* pSig, MSF_SIGNAL_EDGE pfEdge, void* pContext );
+bool MSFSignal_SameMinute( const sMSFDateTime* pA, const sMSFDateTime* pB );
+
+
+
+#endif  // _MSFSIGNAL_H_
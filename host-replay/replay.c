@@ -0,0 +1,417 @@
+
+/********************************************************************************
+ * @file    replay.c
+ * @author  Tony Hanratty
+ * @date    14-Oct-2026
+ *
+ * @brief   Replays recorded radio edges through the MSF decoder on a PC
+ *
+ * @notes   Usage: msf-replay [-q] [-f frames] [-2 cut,start] [trace]
+ *
+ *          The trace is read from stdin if no file is given. Each line is one
+ *          edge: its timestamp in milliseconds and the level of the radio data
+ *          pin after it, 0 or 1. Blank lines and lines starting with '#' are
+ *          ignored, e.g.
+ *
+ *              # MSF trace
+ *              1000 1
+ *              1500 0
+ *
+ *          Every edge goes through MSF_QueueCarrierEdge(), MSF_Process() and
+ *          MSF_DispatchEvents() just as it would on the target, only as fast
+ *          as they'll go.
+ *
+ *          -q          Only print the summary
+ *          -f frames   Exit with status 2 unless exactly this many frames decode
+ *          -2 cut,start
+ *                      Built with MSF_NUM_RECEIVERS > 1, feed the trace to two
+ *                      receivers to try the lead selection & failover. Receiver 0
+ *                      gets the edges before cut ms, receiver 1 the edges from
+ *                      start ms on, each RECEIVER1_DELAY_MS later
+ *
+ ********************************************************************************/
+
+
+// System includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+// Our includes
+#include "config.h"
+#include "MSF60decode.h"
+#include "hostradio.h"
+
+
+
+#if (MSF_NUM_RECEIVERS > 1)
+// Receiver 1's edges come this much later than receiver 0's, as from another board
+#define RECEIVER1_DELAY_MS      30
+
+// Receiver 1's edges waiting for their time to come
+#define PENDING_EDGES           16
+#endif
+
+
+// Indexed by the day-of-week number received from the radio
+static const char *days[] = { "Sun", "Mon", "Tue", "Wed", "Thr", "Fri", "Sat" };
+
+// Indexed by eMSFStatEvent
+static const char *StatEventNames[ MSF_NUM_STAT_EVENTS ] = {
+    "SYNC found",
+    "SYNC on A52 to A59",
+    "SYNC lost",
+    "Missing minute marker",
+    "Missing HALF SYNC",
+    "Unexpected HALF SYNC",
+    "Second markers lost",
+    "Second marker found",
+    "Second marker off",
+    "Bad CARRIER_ON width",
+    "Bad CARRIER_ON offset",
+    "Lost cells",
+    "Bad cell",
+    "Edges lost",
+    "Unknown carrier event"
+};
+
+static sMSFDateTime msf_DateTime;
+
+static uint32_t T_Now = 0;
+static bool     bQuiet = false;
+static uint32_t nFrames = 0;
+static uint32_t nSyncs = 0;
+static uint32_t nSyncsLost = 0;
+static uint32_t nEdges = 0;
+
+#if (MSF_NUM_RECEIVERS > 1)
+static unsigned LeadReceiver = 0;
+static uint32_t PendingTime[ PENDING_EDGES ];
+static uint32_t PendingLevel[ PENDING_EDGES ];
+static unsigned nPendingHead = 0;
+static unsigned nPendingTail = 0;
+#endif
+
+
+
+/**
+ * Decoder event callback, print what happened and when
+ */
+static void
+EventHandler( eMSFEventType ev )
+{
+    switch (ev)
+    {
+        case MSF_EVENT_SYNC:
+            nSyncs++;
+            if (!bQuiet)
+                printf("%10" PRIu32 "  SYNC\n", T_Now);
+            break;
+
+        case MSF_EVENT_SYNC_LOST:
+            nSyncsLost++;
+            if (!bQuiet)
+                printf("%10" PRIu32 "  SYNC lost\n", T_Now);
+            break;
+
+        case MSF_EVENT_DATETIME_UPDATED:
+            nFrames++;
+            MSF_ReadDateTime( &msf_DateTime );
+            if (!bQuiet)
+                printf("%10" PRIu32 "  %s %02u/%02u/%02u %02u:%02u %s DUT1 %c0.%u%s\n", T_Now,
+                       days[ msf_DateTime.DOW % 7 ], msf_DateTime.Day, msf_DateTime.Month, msf_DateTime.Year,
+                       msf_DateTime.Hour, msf_DateTime.Minute, (msf_DateTime.DST) ? "BST" : "GMT",
+                       (msf_DateTime.DUT1 < 0) ? '-' : '+', (unsigned) abs(msf_DateTime.DUT1),
+                       (msf_DateTime.DSTWarning) ? " change due" : "");
+            break;
+    }
+}
+
+
+
+/**
+ * Print one timed section from MSF_GetStats()
+ */
+static void
+PrintCycles( const char* pName, const sMSFCycleStats* pCycles )
+{
+    printf("  %-16s %10" PRIu32 " runs", pName, pCycles->Count);
+
+    if (pCycles->Count)
+        printf(", min %" PRIu32 " max %" PRIu32 " mean %" PRIu64 " ns", pCycles->MinCycles, pCycles->MaxCycles,
+               pCycles->TotalCycles / pCycles->Count);
+
+    printf("\n");
+}
+
+
+
+/**
+ * Print one of the pulse width histograms
+ */
+static void
+PrintWidths( const char* pName, const uint32_t* pWidths )
+{
+    unsigned i;
+
+    printf("%-16s", pName);
+    for (i = 0 ; i < MSF_STAT_WIDTH_BINS ; i++)
+        printf(" %u:%" PRIu32, i * 100, pWidths[ i ]);
+    printf("\n");
+}
+
+
+
+/**
+ * Print the decoder statistics, if they're enabled
+ */
+static void
+PrintStats( void )
+{
+    sMSFStats stats;
+    unsigned i;
+
+    if (!MSF_GetStats( &stats ))
+        return;
+
+    printf("Marker failures  %" PRIu32 "\n", stats.MarkerFailures);
+    printf("Parity failures  %" PRIu32 "\n", stats.ParityFailures);
+    printf("Range failures   %" PRIu32 "\n", stats.RangeFailures);
+    printf("Voted failures   %" PRIu32 "\n", stats.VotedFailures);
+    printf("Frames held      %" PRIu32 "\n", stats.FramesHeld);
+    printf("Edges merged     %" PRIu32 "\n", stats.EdgesMerged);
+    printf("Glitches         %" PRIu32 "\n", stats.GlitchesRejected);
+
+    for (i = 0 ; i < MSF_NUM_STAT_EVENTS ; i++)
+        if (stats.Events[ i ])
+            printf("  %-24s %" PRIu32 "\n", StatEventNames[ i ], stats.Events[ i ]);
+
+    PrintWidths( "OFF widths", stats.OffWidths );
+    PrintWidths( "ON widths", stats.OnWidths );
+    PrintWidths( "Cell offsets", stats.CellOffsets );
+
+    PrintCycles( "Radio ISR", &stats.RadioIsr );
+    PrintCycles( "Carrier event", &stats.CarrierEvent );
+    PrintCycles( "Decode frame", &stats.DecodeFrame );
+    PrintCycles( "Client callback", &stats.ClientCallback );
+}
+
+
+
+/**
+ * Print the signal quality at the end of the trace, if it's measured
+ */
+static void
+PrintQuality( void )
+{
+    sMSFSignalQuality quality;
+    unsigned i;
+
+    if (!MSF_GetSignalQuality( 0, &quality ))
+        return;
+
+    printf("Lock quality %u, %u%% edges in margin, mean error %u us, %u bit errors per 1000\n",
+           quality.LockQuality, quality.EdgesInMargin, quality.EdgeErrorUs, quality.BitErrorsPerMille);
+
+    printf("Edge errors     ");
+    for (i = 0 ; i < MSF_QUALITY_ERROR_BINS - 1 ; i++)
+        printf(" %u:%" PRIu32, i * 5, quality.ErrorHistogram[ i ]);
+    printf(" out:%" PRIu32 "\n", quality.ErrorHistogram[ MSF_QUALITY_ERROR_BINS - 1 ]);
+
+    printf("ON edge bias %d ms, margin %u ms%s\n", quality.OnEdgeBiasMs, quality.MarginMs,
+           (quality.bInverted) ? ", receiver output inverted" : "");
+}
+
+
+
+/**
+ * The edge arrives at time t, the ISR queues it & the main loop decodes it
+ */
+static void
+ReplayEdge( unsigned receiver, uint32_t t, uint32_t level )
+{
+    T_Now = t;
+    HostRadio_SetTickCount( T_Now );
+    MSF_QueueCarrierEdge( receiver, level, T_Now );
+    MSF_Process();
+    MSF_DispatchEvents();
+    nEdges++;
+
+#if (MSF_NUM_RECEIVERS > 1)
+    if (MSF_GetLeadReceiver() != LeadReceiver)
+    {
+        LeadReceiver = MSF_GetLeadReceiver();
+        if (!bQuiet)
+            printf("%10" PRIu32 "  Receiver %u leads\n", T_Now, LeadReceiver);
+    }
+#endif
+}
+
+
+
+#if (MSF_NUM_RECEIVERS > 1)
+/**
+ * Replay receiver 1's edges that are due by time t, so both receivers' edges go in in order
+ */
+static void
+ReplayPending( uint32_t t )
+{
+    unsigned n;
+
+    while ((nPendingTail != nPendingHead) && ((int32_t)(t - PendingTime[ nPendingTail ]) >= 0))
+    {
+        n = nPendingTail;
+        nPendingTail = (nPendingTail + 1) % PENDING_EDGES;
+        ReplayEdge( 1, PendingTime[ n ], PendingLevel[ n ] );
+    }
+}
+
+
+
+/**
+ * Hold one of receiver 1's edges back until RECEIVER1_DELAY_MS after time t
+ */
+static void
+AddPending( uint32_t t, uint32_t level )
+{
+    // Full, the oldest is overdue anyway
+    if ((nPendingHead + 1) % PENDING_EDGES == nPendingTail)
+        ReplayPending( PendingTime[ nPendingTail ] );
+
+    PendingTime[ nPendingHead ]  = t + RECEIVER1_DELAY_MS;
+    PendingLevel[ nPendingHead ] = level;
+    nPendingHead = (nPendingHead + 1) % PENDING_EDGES;
+}
+#endif
+
+
+
+static void
+Usage( void )
+{
+#if (MSF_NUM_RECEIVERS > 1)
+    fprintf(stderr, "Usage: msf-replay [-q] [-f frames] [-2 cut,start] [trace]\n");
+#else
+    fprintf(stderr, "Usage: msf-replay [-q] [-f frames] [trace]\n");
+#endif
+    exit(1);
+}
+
+
+
+int
+main( int argc, char* argv[] )
+{
+    FILE* fp = stdin;
+    const char* pName = "stdin";
+    char line[ 128 ];
+    unsigned long t, level;
+    uint32_t nLine = 0;
+    long nExpected = -1;
+#if (MSF_NUM_RECEIVERS > 1)
+    bool bTwoReceivers = false;
+    unsigned long T_Cut = 0, T_Start = 0;
+    unsigned receiver;
+#endif
+    char* p;
+    int i;
+
+    for (i = 1 ; (i < argc) && (argv[ i ][ 0 ] == '-') && (argv[ i ][ 1 ] != '\0') ; i++)
+    {
+        if (strcmp(argv[ i ], "-q") == 0)
+            bQuiet = true;
+        else if ((strcmp(argv[ i ], "-f") == 0) && (i + 1 < argc))
+            nExpected = strtol(argv[ ++i ], NULL, 0);
+#if (MSF_NUM_RECEIVERS > 1)
+        else if ((strcmp(argv[ i ], "-2") == 0) && (i + 1 < argc) &&
+                 (sscanf(argv[ ++i ], "%lu,%lu", &T_Cut, &T_Start) == 2))
+            bTwoReceivers = true;
+#endif
+        else
+            Usage();
+    }
+
+    if (i + 1 < argc)
+        Usage();
+
+    if ((i < argc) && (strcmp(argv[ i ], "-") != 0))
+    {
+        pName = argv[ i ];
+        fp = fopen(pName, "r");
+        if (!fp)
+        {
+            perror(pName);
+            return 1;
+        }
+    }
+
+    MSF_InitDecoder( NULL );
+    MSF_EnableEventNotifications( EventHandler, MSF_EVENT_SYNC | MSF_EVENT_SYNC_LOST | MSF_EVENT_DATETIME_UPDATED );
+    MSF_EnableRadio( true );
+
+    while (fgets(line, sizeof(line), fp))
+    {
+        nLine++;
+
+        for (p = line ; (*p == ' ') || (*p == '\t') ; p++)
+            ;
+
+        if ((*p == '#') || (*p == '\n') || (*p == '\r') || (*p == '\0'))
+            continue;
+
+        if ((sscanf(p, "%lu %lu", &t, &level) != 2) || (level > 1))
+        {
+            fprintf(stderr, "%s:%" PRIu32 ": expected <time> <level>\n", pName, nLine);
+            return 1;
+        }
+
+#if (MSF_NUM_RECEIVERS > 1)
+        if (bTwoReceivers)
+        {
+            ReplayPending( (uint32_t) t );
+            if (t < T_Cut)
+                ReplayEdge( 0, (uint32_t) t, (uint32_t) level );
+            if (t >= T_Start)
+                AddPending( (uint32_t) t, (uint32_t) level );
+            continue;
+        }
+#endif
+
+        ReplayEdge( 0, (uint32_t) t, (uint32_t) level );
+    }
+
+#if (MSF_NUM_RECEIVERS > 1)
+    ReplayPending( T_Now + RECEIVER1_DELAY_MS );
+#endif
+
+    if (fp != stdin)
+        fclose(fp);
+
+    // A SYNC_LOST at the very end is held back for coalescing, let it go
+    HostRadio_SetTickCount( T_Now + MSF_EVENT_COALESCE_MS );
+    MSF_DispatchEvents();
+
+    printf("%" PRIu32 " edges, %" PRIu32 " frames decoded, %" PRIu32 " SYNC, %" PRIu32 " SYNC lost\n",
+           nEdges, nFrames, nSyncs, nSyncsLost);
+
+#if (MSF_NUM_RECEIVERS > 1)
+    if (bTwoReceivers)
+    {
+        printf("Receiver %u leads", MSF_GetLeadReceiver());
+        for (receiver = 0 ; receiver < MSF_NUM_RECEIVERS ; receiver++)
+            printf(", receiver %u %s", receiver, (MSF_GetReceiverSyncState( receiver )) ? "in SYNC" : "no SYNC");
+        printf("\n");
+    }
+#endif
+
+    PrintQuality();
+    PrintStats();
+
+    if ((nExpected >= 0) && ((uint32_t) nExpected != nFrames))
+        return 2;
+
+    return 0;
+}